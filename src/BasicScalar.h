@@ -0,0 +1,47 @@
+#ifndef METAL_BASICSCALAR_H
+#define METAL_BASICSCALAR_H
+
+
+#include "src/Scalar.h"
+#include "src/ValueScalar.h"
+
+
+namespace metal
+{
+
+/**
+ * @brief Derivative policy computing values and forward-mode partial derivatives.
+ *
+ */
+struct WithDerivatives
+{
+    /** Alias for the scalar type of the policy */
+    using Type = Scalar;
+};
+
+/**
+ * @brief Derivative policy computing values only, at the speed of plain double arithmetic.
+ *
+ */
+struct NoDerivatives
+{
+    /** Alias for the scalar type of the policy */
+    using Type = ValueScalar;
+};
+
+/**
+ * @brief Alias for the scalar type selected by a derivative policy.
+ *
+ * Model code written once against `BasicScalar< Policy >` (or templated on the scalar type) can
+ * be compiled with derivatives using \ref WithDerivatives, which gives \ref Scalar, and without
+ * them using \ref NoDerivatives, which gives \ref ValueScalar. In the latter case parameter
+ * creating constructors are no-ops, and no expression templates are involved.
+ *
+ * @tparam Policy Derivative policy
+ */
+template< typename Policy >
+using BasicScalar = typename Policy::Type;
+
+} // metal
+
+#endif // METAL_BASICSCALAR_H
@@ -0,0 +1,103 @@
+#ifndef METAL_BINARYMATHOP_H
+#define METAL_BINARYMATHOP_H
+
+
+#include "src/ScalarBinaryOp.h"
+#include <cmath>
+
+
+namespace metal
+{
+
+/**
+ * @brief Binary operation taken by \ref ScalarBinaryOp object to define the expression for
+ * raising an expression to the power of another expression.
+ *
+ * The partial w.r.t. the exponent, value * log(base), is only real for a positive base. It is
+ * discarded by \ref ScalarBinaryOp for an exponent known to have no parameters, see
+ * \ref ParameterFree, so that a negative base raised to a constant exponent has finite partials.
+ * For a negative base and an exponent with parameters the partial w.r.t. the exponent is NaN.
+ */
+struct BinaryPowerOp
+{
+    /**
+     * @brief Applies the transformation on the values of the expressions and computes the partial
+     * derivatives of the operation. Both partials are computed from the value, except for a zero
+     * base.
+     *
+     * @param left Base
+     * @param right Exponent
+     * @return BinaryResult Result of operation and partials w.r.t. the base and exponent
+     */
+    BinaryResult apply( double left, double right ) const
+    {
+        const double tmp = std::pow( left, right );
+        if ( std::fabs( left ) <= 0.0 )
+        {
+            return BinaryResult{ tmp, right * std::pow( left, right - 1.0 ), 0.0 };
+        }
+        return BinaryResult{ tmp, right * tmp / left, tmp * std::log( left ) };
+    }
+};
+
+
+/**
+ * @brief Power function raising an expression to the power of another expression.
+ *
+ * @tparam Left Type of the base expression
+ * @tparam Right Type of the exponent expression
+ * @param left Base expression
+ * @param right Exponent expression
+ * @return ScalarBinaryOp< Left, Right, BinaryPowerOp > Expression that represents the power
+ */
+template< typename Left, typename Right >
+ScalarBinaryOp< Left, Right, BinaryPowerOp > pow(
+    const ScalarBase< Left >& left, const ScalarBase< Right >& right )
+{
+    return ScalarBinaryOp< Left, Right, BinaryPowerOp >( static_cast< const Left& >( left ),
+        static_cast< const Right& >( right ), BinaryPowerOp{} );
+}
+
+
+/**
+ * @brief Binary operation taken by \ref ScalarBinaryOp object to define the expression for
+ * computing the hypotenuse of two expressions without intermediate overflow or underflow.
+ */
+struct HypotOp
+{
+    /**
+     * @brief Applies the transformation on the values of the expressions and computes the partial
+     * derivatives of the operation, which are computed from the value.
+     *
+     * @param left LHS of the operation
+     * @param right RHS of the operation
+     * @return BinaryResult Result of operation and partials w.r.t. the LHS and RHS
+     */
+    BinaryResult apply( double left, double right ) const
+    {
+        const double tmp = std::hypot( left, right );
+        return BinaryResult{ tmp, left / tmp, right / tmp };
+    }
+};
+
+
+/**
+ * @brief Hypotenuse function for two expressions.
+ *
+ * @tparam Left Type of the LHS expression
+ * @tparam Right Type of the RHS expression
+ * @param left LHS expression
+ * @param right RHS expression
+ * @return ScalarBinaryOp< Left, Right, HypotOp > Expression that represents the hypotenuse
+ */
+template< typename Left, typename Right >
+ScalarBinaryOp< Left, Right, HypotOp > hypot(
+    const ScalarBase< Left >& left, const ScalarBase< Right >& right )
+{
+    return ScalarBinaryOp< Left, Right, HypotOp >(
+        static_cast< const Left& >( left ), static_cast< const Right& >( right ), HypotOp{} );
+}
+
+} // metal
+
+#endif // METAL_BINARYMATHOP_H
@@ -10,68 +10,27 @@ namespace metal
 {
 
 /**
- * @brief Unary operation taken by \ref ScalarBinaryOp object to define the expression for
- * computing the sine of an expression.
+ * @brief Binary operation taken by \ref ScalarBinaryOp object to define the expression for
+ * computing the two-argument arc tangent of two expressions.
+ *
+ * The operation is stateless: the value and both partials are computed together once, when the
+ * expression node is constructed, so expressions can be evaluated from several threads.
  */
-class Atan2Op
+struct Atan2Op
 {
-
-public:
     /**
-     * @brief Applies the transformation on the value of an expression.
+     * @brief Applies the transformation on the values of the expressions and computes the partial
+     * derivatives of the operation, sharing the squared norm between them.
      *
      * @param left LHS of the operation
      * @param right RHS of the operation
-     * @return double Result of operation
+     * @return BinaryResult Result of operation and partials w.r.t. the LHS and RHS
      */
-    double applyToValue( double left, double right ) const
+    BinaryResult apply( double left, double right ) const
     {
-        return std::atan2( left, right );
+        const double inverse = 1.0 / ( left * left + right * right );
+        return BinaryResult{ std::atan2( left, right ), right * inverse, -left * inverse };
     }
-
-    /**
-     * @brief Computes the partial derivative of the result w.r.t the LHS.
-     *
-     * @return double Partial w.r.t. the LHS
-     */
-    double leftPartial( double left, double right ) const
-    {
-        return right / cache( left, right );
-    }
-
-    /**
-     * @brief Computes the partial derivative of the result w.r.t the RHS.
-     *
-     * @return double Partial w.r.t. the RHS
-     */
-    double rightPartial( double left, double right ) const
-    {
-        return -left / cache( left, right );
-    }
-
-private:
-    struct Cache
-    {
-        static bool same( double left, double right )
-        {
-            return std::fabs( left - right ) <= 0.0;
-        }
-
-        double left;
-        double right;
-        double norm;
-    };
-
-    double cache( double left, double right ) const
-    {
-        if ( !Cache::same( left, cache_.left ) || !Cache::same( right, cache_.right ) )
-        {
-            cache_ = { left, right, left * left + right * right };
-        }
-        return cache_.norm;
-    }
-
-    mutable Cache cache_;
 };
 
 
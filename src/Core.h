@@ -4,6 +4,12 @@
 
 #include "src/ScalarBase.h"
 #include "src/Scalar.h"
+#include "src/ScalarN.h"
+#include "src/ScalarAccumulator.h"
+#include "src/EvaluationPlan.h"
+#include "src/ValueScalar.h"
+#include "src/BasicScalar.h"
+#include "src/TapeScalar.h"
 #include "src/ScalarUnaryOp.h"
 #include "src/UnaryNegateOp.h"
 #include "src/UnaryAdditionOp.h"
@@ -18,7 +24,11 @@
 #include "src/BinarySubtractionOp.h"
 #include "src/BinaryMultiplyOp.h"
 #include "src/BinaryDivisionOp.h"
+#include "src/BinaryMathOp.h"
 #include "src/BinaryTrigonOp.h"
+#include "src/ScalarNaryOp.h"
+#include "src/NaryAdditionOp.h"
+#include "src/NaryMultiplyOp.h"
 
 
 #endif // METAL_CORE_H
@@ -0,0 +1,305 @@
+#ifndef METAL_EVALUATIONPLAN_H
+#define METAL_EVALUATIONPLAN_H
+
+
+#include "src/ParameterLayout.h"
+#include "src/PartialVector.h"
+#include "src/ScalarBase.h"
+#include "src/ScatterSink.h"
+#include <vector>
+
+
+namespace metal
+{
+
+/**
+ * @brief Cache of the layout work of evaluating an expression at one call site.
+ *
+ * Evaluating an expression into a \ref Scalar merges the parameters of all leaves, interns the
+ * resulting layout and matches every leaf parameter with its offset in the result. Inside a
+ * propagation loop the same expression is evaluated again and again with leaves of the same
+ * layouts, so this work gives the same result at every step.
+ *
+ * The first evaluation with a plan records the layout of every leaf in scatter order, the result
+ * layout and, for every leaf, the runs of contiguous partials to add to the result. Later
+ * evaluations check the leaf layouts while scattering, which is a pointer comparison per leaf,
+ * and only add the recorded runs. If any leaf layout differs, the expression is evaluated as
+ * usual and the plan is recorded again.
+ *
+ * A plan is meant to be declared once per call site, e.g. as `static thread_local`, and must not
+ * be shared between threads. The recorded leaf layouts are kept alive by the plan, so that the
+ * address of a released layout can never match a different one.
+ */
+class EvaluationPlan
+{
+
+public:
+    /**
+     * @brief Returns whether a plan has been recorded.
+     *
+     * @return true A plan is available for replay
+     * @return false Nothing has been recorded yet
+     */
+    bool recorded() const
+    {
+        return recorded_;
+    }
+
+    /**
+     * @brief Returns the recorded layout of the result.
+     *
+     * @return const LayoutPtr& Result layout, null pointer if there are no partials
+     */
+    const LayoutPtr& layout() const
+    {
+        return layout_;
+    }
+
+    /**
+     * @brief Returns the number of evaluations which reused the recorded plan.
+     *
+     * @return size_t Number of replays
+     */
+    size_t hits() const
+    {
+        return hits_;
+    }
+
+    /**
+     * @brief Returns the number of evaluations which had to record the plan.
+     *
+     * @return size_t Number of recordings
+     */
+    size_t misses() const
+    {
+        return misses_;
+    }
+
+    /**
+     * @brief Discards the recorded plan.
+     *
+     */
+    void clear()
+    {
+        recorded_ = false;
+        layout_.reset();
+        leaves_.clear();
+        begins_.clear();
+        runs_.clear();
+    }
+
+    /**
+     * @brief Evaluates the partials of an expression with the recorded plan, in dense mode.
+     *
+     * @tparam Expr Type of expression to evaluate
+     * @param expr Expression to evaluate
+     * @param partial Target partial vector, only meaningful on success
+     * @return true The leaf layouts match the plan and the partials are evaluated
+     * @return false The leaf layouts differ, the plan has to be recorded again
+     */
+    template< typename Expr >
+    bool replay( const ScalarBase< Expr >& expr, PartialVector& partial )
+    {
+        if ( !recorded_ )
+        {
+            return false;
+        }
+        partial.setZero( layout_ ? layout_->dim() : 0 );
+        Replay sink{ *this, partial.data() };
+        expr.scatter( sink, 1.0 );
+        if ( !sink.matches() )
+        {
+            return false;
+        }
+        ++hits_;
+        return true;
+    }
+
+    /**
+     * @brief Records the plan of an expression evaluated into a given layout.
+     *
+     * @tparam Expr Type of expression to record
+     * @param expr Expression to record
+     * @param layout Layout of the evaluated expression
+     */
+    template< typename Expr >
+    void record( const ScalarBase< Expr >& expr, const LayoutPtr& layout )
+    {
+        clear();
+        layout_ = layout;
+        Record sink{ *this };
+        expr.scatter( sink, 1.0 );
+        begins_.push_back( runs_.size() );
+        recorded_ = true;
+        ++misses_;
+    }
+
+private:
+    /** Contiguous partials of a leaf added to contiguous partials of the result */
+    struct Run
+    {
+        /** Offset in the leaf partial vector */
+        int source;
+
+        /** Offset in the result partial vector */
+        int target;
+
+        /** Number of elements */
+        int size;
+    };
+
+    /** Sink recording the layout and runs of every leaf */
+    class Record
+    {
+
+    public:
+        /**
+         * @brief Construct a new Record object.
+         *
+         * @param plan Plan to record into, cleared and with the result layout already set
+         */
+        explicit Record( EvaluationPlan& plan )
+            : plan_( plan )
+        {
+        }
+
+        /**
+         * @brief Records the layout of a leaf and the runs of its partials in the result.
+         *
+         * @tparam Leaf Type of the leaf
+         * @param leaf Leaf of the expression
+         */
+        template< typename Leaf >
+        void operator()( const Leaf& leaf, double )
+        {
+            const LayoutPtr& layout = leaf.layout();
+            plan_.leaves_.push_back( layout );
+            plan_.begins_.push_back( plan_.runs_.size() );
+            if ( !layout )
+            {
+                return;
+            }
+
+            // Both layouts are sorted by identifier, so their parameters are matched by merging
+            const ParameterLayout& target = *plan_.layout_;
+            const size_t first = plan_.runs_.size();
+            size_t j = target.find( layout->id( 0 ) );
+            for ( size_t i = 0; i < layout->size(); i++ )
+            {
+                while ( target.id( j ) != layout->id( i ) )
+                {
+                    ++j;
+                }
+                const Run run{ layout->offset( i ), target.offset( j ), layout->dim( i ) };
+                Run* last = plan_.runs_.size() > first ? &plan_.runs_.back() : nullptr;
+                if ( last && last->source + last->size == run.source
+                    && last->target + last->size == run.target )
+                {
+                    last->size += run.size;
+                }
+                else
+                {
+                    plan_.runs_.push_back( run );
+                }
+            }
+        }
+
+    private:
+        /** Plan being recorded */
+        EvaluationPlan& plan_;
+    };
+
+    /** Sink checking the leaf layouts against the plan and adding the recorded runs */
+    class Replay
+    {
+
+    public:
+        /**
+         * @brief Construct a new Replay object.
+         *
+         * @param plan Recorded plan
+         * @param target Dense partials of the result, zeroed and of the recorded dimension
+         */
+        Replay( const EvaluationPlan& plan, double* target )
+            : plan_( plan )
+            , target_( target )
+            , leaf_{ 0 }
+            , matches_{ true }
+        {
+        }
+
+        /**
+         * @brief Checks the layout of the next leaf against the plan and adds its weighted
+         * partials along the recorded runs. After the first mismatch all leaves are ignored.
+         *
+         * @tparam Leaf Type of the leaf
+         * @param leaf Leaf of the expression
+         * @param scalar Weight of the leaf
+         */
+        template< typename Leaf >
+        void operator()( const Leaf& leaf, double scalar )
+        {
+            if ( !matches_ || leaf_ == plan_.leaves_.size()
+                || leaf.layout().get() != plan_.leaves_[leaf_].get() )
+            {
+                matches_ = false;
+                return;
+            }
+            for ( size_t k = plan_.begins_[leaf_]; k < plan_.begins_[leaf_ + 1]; k++ )
+            {
+                const Run& run = plan_.runs_[k];
+                detail::addTo( leaf.partial(), target_ + run.target, run.source, run.size, scalar );
+            }
+            ++leaf_;
+        }
+
+        /**
+         * @brief Returns whether the scattered leaves matched the plan, in number and layouts.
+         *
+         * @return true The partials of the result are complete
+         * @return false The plan has to be recorded again
+         */
+        bool matches() const
+        {
+            return matches_ && leaf_ == plan_.leaves_.size();
+        }
+
+    private:
+        /** Recorded plan */
+        const EvaluationPlan& plan_;
+
+        /** Dense partials of the result */
+        double* target_;
+
+        /** Position of the next leaf in the plan */
+        size_t leaf_;
+
+        /** Whether all leaves so far matched the plan */
+        bool matches_;
+    };
+
+    /** Whether a plan has been recorded */
+    bool recorded_ = false;
+
+    /** Layout of the result */
+    LayoutPtr layout_;
+
+    /** Layouts of the leaves in scatter order */
+    std::vector< LayoutPtr > leaves_;
+
+    /** Index of the first run of every leaf, followed by the total number of runs */
+    std::vector< size_t > begins_;
+
+    /** Runs of all leaves */
+    std::vector< Run > runs_;
+
+    /** Number of replayed evaluations */
+    size_t hits_ = 0;
+
+    /** Number of recorded evaluations */
+    size_t misses_ = 0;
+};
+
+} // metal
+
+#endif // METAL_EVALUATIONPLAN_H
@@ -0,0 +1,732 @@
+#ifndef METAL_JETMATRIX_H
+#define METAL_JETMATRIX_H
+
+
+#include "src/Matrix.h"
+#include <string>
+
+
+namespace metal
+{
+
+namespace detail
+{
+
+    /**
+     * @brief Adds weighted derivative columns w.r.t. one layout to derivative columns w.r.t. a
+     * layout containing it. The columns of every parameter are contiguous, so they are added
+     * blockwise.
+     *
+     * @param target Derivative columns w.r.t. the target layout
+     * @param layout Target layout
+     * @param source Derivative columns w.r.t. the source layout
+     * @param from Source layout, a subset of the target layout
+     * @param scalar Weight
+     */
+    inline void addColumns( Eigen::MatrixXd& target, const ParameterLayout& layout,
+        const Eigen::MatrixXd& source, const ParameterLayout& from, double scalar )
+    {
+        if ( &layout == &from )
+        {
+            target += scalar * source;
+            return;
+        }
+        size_t j = layout.find( from.id( 0 ) );
+        for ( size_t i = 0; i < from.size(); i++ )
+        {
+            while ( layout.id( j ) != from.id( i ) )
+            {
+                ++j;
+            }
+            target.middleCols( layout.offset( j ), from.dim( i ) )
+                += scalar * source.middleCols( from.offset( i ), from.dim( i ) );
+        }
+    }
+
+
+    /**
+     * @brief Multiplies every derivative slice by a matrix from the right, S_k B. The slices are
+     * stacked vertically into one matrix, so that all of them are multiplied at once.
+     *
+     * @tparam Rhs Type of RHS matrix
+     * @param partial Derivative columns, every column the stacked columns of a slice
+     * @param rows Number of rows of a slice
+     * @param right RHS matrix, with as many rows as a slice has columns
+     * @return Eigen::MatrixXd Derivative columns of the products
+     */
+    template< typename Rhs >
+    Eigen::MatrixXd sliceTimes(
+        const Eigen::MatrixXd& partial, Eigen::Index rows, const Eigen::MatrixBase< Rhs >& right )
+    {
+        const Eigen::Index inner = right.rows();
+        const Eigen::Index cols = right.cols();
+        const Eigen::Index dim = partial.cols();
+        Eigen::MatrixXd stacked( rows * dim, inner );
+        for ( Eigen::Index k = 0; k < dim; k++ )
+        {
+            stacked.middleRows( rows * k, rows )
+                = Eigen::Map< const Eigen::MatrixXd >{ partial.col( k ).data(), rows, inner };
+        }
+        const Eigen::MatrixXd product = stacked * right;
+
+        Eigen::MatrixXd slices( rows * cols, dim );
+        for ( Eigen::Index k = 0; k < dim; k++ )
+        {
+            Eigen::Map< Eigen::MatrixXd >{ slices.col( k ).data(), rows, cols }
+                = product.middleRows( rows * k, rows );
+        }
+        return slices;
+    }
+
+    /**
+     * @brief Multiplies every derivative slice by a matrix from the left, A S_k. The slices lie
+     * next to each other in memory, so all of them are multiplied at once.
+     *
+     * @tparam Lhs Type of LHS matrix
+     * @param left LHS matrix, with as many columns as a slice has rows
+     * @param partial Derivative columns, every column the stacked columns of a slice
+     * @param cols Number of columns of a slice
+     * @return Eigen::MatrixXd Derivative columns of the products
+     */
+    template< typename Lhs >
+    Eigen::MatrixXd timesSlice(
+        const Eigen::MatrixBase< Lhs >& left, const Eigen::MatrixXd& partial, Eigen::Index cols )
+    {
+        const Eigen::Index dim = partial.cols();
+        Eigen::MatrixXd slices( left.rows() * cols, dim );
+        Eigen::Map< Eigen::MatrixXd >{ slices.data(), left.rows(), cols * dim }.noalias()
+            = left * Eigen::Map< const Eigen::MatrixXd >{ partial.data(), left.cols(), cols * dim };
+        return slices;
+    }
+
+} // detail
+
+
+/**
+ * @brief Matrix of values with partial derivatives, stored as structure of arrays.
+ *
+ * An Eigen matrix of \ref Scalar objects stores a separate partial vector and layout per element,
+ * and every Eigen operation creates a new scalar per element. This matrix instead stores one
+ * Eigen value matrix and one contiguous derivative matrix with a layout shared by all elements.
+ *
+ * The derivative matrix has one row per element, in column-major order, and one column per
+ * derivative component of the layout. Its column k is therefore the vectorized derivative slice
+ * of the whole matrix w.r.t. component k, see \ref slice, and the slices of all components lie
+ * next to each other in memory. Arithmetic is done with whole-matrix Eigen operations on the
+ * values and the derivative matrix.
+ *
+ * @tparam Rows Number of rows, may be Eigen::Dynamic
+ * @tparam Cols Number of columns, may be Eigen::Dynamic
+ */
+template< int Rows, int Cols >
+class JetMatrix
+{
+
+public:
+    /** Alias for the value matrix type */
+    using Value = Eigen::Matrix< double, Rows, Cols >;
+
+    /** Alias for the derivative matrix type, one row per element and one column per component */
+    using Derivative = Eigen::MatrixXd;
+
+    /** Alias for the view of the derivative slice w.r.t. one component */
+    using Slice = Eigen::Map< Value >;
+
+    /** Alias for the constant view of the derivative slice w.r.t. one component */
+    using ConstSlice = Eigen::Map< const Value >;
+
+
+    /**
+     * @brief Construct a new empty Jet Matrix object. Fixed size matrices are not initialized.
+     *
+     */
+    JetMatrix()
+        : value_{}
+        , partial_( value_.size(), 0 )
+        , layout_{}
+    {
+    }
+
+    /**
+     * @brief Construct a new Jet Matrix object without partial derivatives.
+     *
+     * @param value Value of the matrix
+     */
+    explicit JetMatrix( const Value& value )
+        : value_{ value }
+        , partial_( value.size(), 0 )
+        , layout_{}
+    {
+    }
+
+    /**
+     * @brief Construct a new Jet Matrix object from a value, a layout and the derivative matrix
+     * w.r.t. it.
+     *
+     * @throws std::runtime_error
+     *
+     * @param value Value of the matrix
+     * @param layout Layout of the derivatives, null pointer for no partials
+     * @param partial Derivative matrix, one row per element in column-major order
+     */
+    JetMatrix( const Value& value, const LayoutPtr& layout, const Derivative& partial )
+        : value_{ value }
+        , partial_{ partial }
+        , layout_{ layout }
+    {
+        const int dim = layout_ ? layout_->dim() : 0;
+        if ( partial_.rows() != value_.size() || partial_.cols() != dim )
+        {
+            throw std::runtime_error( "Error! Derivative matrix of size "
+                + std::to_string( partial_.rows() ) + "x" + std::to_string( partial_.cols() )
+                + " does not match the matrix size and layout dimension" );
+        }
+    }
+
+    /**
+     * @brief Construct a new Jet Matrix object from a matrix of scalars. The layout is the union
+     * of the parameters of all elements.
+     *
+     * @param matrix Matrix of scalars
+     */
+    explicit JetMatrix( const MatrixT< Rows, Cols >& matrix )
+        : value_{}
+        , partial_{}
+        , layout_{}
+    {
+        value_.resize( matrix.rows(), matrix.cols() );
+        std::vector< const LayoutPtr* > layouts( static_cast< size_t >( matrix.size() ) );
+        for ( int k = 0; k < matrix.size(); k++ )
+        {
+            layouts[static_cast< size_t >( k )] = &matrix( k ).layout();
+        }
+        layout_ = ParameterLayout::merge( layouts );
+        partial_.setZero( matrix.size(), layout_ ? layout_->dim() : 0 );
+
+        for ( int k = 0; k < matrix.size(); k++ )
+        {
+            const Scalar& x = matrix( k );
+            value_( k ) = x.value();
+            if ( !x.layout() )
+            {
+                continue;
+            }
+            const EigenRowVector partial = x.partial().toDense();
+            const ParameterLayout& from = *x.layout();
+            size_t j = layout_->find( from.id( 0 ) );
+            for ( size_t i = 0; i < from.size(); i++ )
+            {
+                while ( layout_->id( j ) != from.id( i ) )
+                {
+                    ++j;
+                }
+                partial_.row( k ).segment( layout_->offset( j ), from.dim( i ) )
+                    = partial.segment( from.offset( i ), from.dim( i ) );
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the number of rows.
+     *
+     * @return Eigen::Index Number of rows
+     */
+    Eigen::Index rows() const
+    {
+        return value_.rows();
+    }
+
+    /**
+     * @brief Returns the number of columns.
+     *
+     * @return Eigen::Index Number of columns
+     */
+    Eigen::Index cols() const
+    {
+        return value_.cols();
+    }
+
+    /**
+     * @brief Returns the number of elements.
+     *
+     * @return Eigen::Index Number of elements
+     */
+    Eigen::Index size() const
+    {
+        return value_.size();
+    }
+
+    /**
+     * @brief Returns the number of derivative components.
+     *
+     * @return int Dimension of the layout
+     */
+    int dim() const
+    {
+        return static_cast< int >( partial_.cols() );
+    }
+
+    /**
+     * @brief Returns the value matrix.
+     *
+     * @return const Value& Value matrix
+     */
+    const Value& value() const
+    {
+        return value_;
+    }
+
+    /**
+     * @brief Returns the derivative matrix, one row per element in column-major order and one
+     * column per derivative component.
+     *
+     * @return const Derivative& Derivative matrix
+     */
+    const Derivative& partial() const
+    {
+        return partial_;
+    }
+
+    /**
+     * @brief Returns the layout shared by all elements.
+     *
+     * @return const LayoutPtr& Layout, null pointer if there are no partials
+     */
+    const LayoutPtr& layout() const
+    {
+        return layout_;
+    }
+
+    /**
+     * @brief Returns the parameters of the layout.
+     *
+     * @return const ParameterPtrVector& Parameters in canonical order
+     */
+    const ParameterPtrVector& parameters() const
+    {
+        static const ParameterPtrVector empty{};
+        return layout_ ? layout_->parameters() : empty;
+    }
+
+    /**
+     * @brief Returns the derivative of the whole matrix w.r.t. one derivative component.
+     *
+     * @param k Index of the component
+     * @return ConstSlice Derivative slice with the shape of the matrix
+     */
+    ConstSlice slice( int k ) const
+    {
+        return ConstSlice{ partial_.col( k ).data(), rows(), cols() };
+    }
+
+    /**
+     * @brief Returns the derivative of the whole matrix w.r.t. one derivative component.
+     *
+     * @param k Index of the component
+     * @return Slice Derivative slice with the shape of the matrix
+     */
+    Slice slice( int k )
+    {
+        return Slice{ partial_.col( k ).data(), rows(), cols() };
+    }
+
+    /**
+     * @brief Returns an element as a scalar.
+     *
+     * @param i Row index
+     * @param j Column index
+     * @return Scalar Element with its partials
+     */
+    Scalar operator()( Eigen::Index i, Eigen::Index j ) const
+    {
+        const Eigen::Index k = j * rows() + i;
+        return layout_ ? Scalar{ value_( k ), layout_, partial_.row( k ) } : Scalar{ value_( k ) };
+    }
+
+    /**
+     * @brief Converts the matrix into a matrix of scalars, which all refer to the shared layout.
+     *
+     * @return MatrixT< Rows, Cols > Matrix of scalars
+     */
+    MatrixT< Rows, Cols > toMatrix() const
+    {
+        MatrixT< Rows, Cols > out;
+        out.resize( rows(), cols() );
+        for ( Eigen::Index j = 0; j < cols(); j++ )
+        {
+            for ( Eigen::Index i = 0; i < rows(); i++ )
+            {
+                out( i, j ) = ( *this )( i, j );
+            }
+        }
+        return out;
+    }
+
+    /**
+     * @brief Returns the transposed matrix, whose derivative slices are the transposed slices.
+     *
+     * @return JetMatrix< Cols, Rows > Transposed matrix
+     */
+    JetMatrix< Cols, Rows > transpose() const
+    {
+        typename JetMatrix< Cols, Rows >::Derivative partial( size(), dim() );
+        for ( int k = 0; k < dim(); k++ )
+        {
+            typename JetMatrix< Cols, Rows >::Slice{ partial.col( k ).data(), cols(), rows() }
+                = slice( k ).transpose();
+        }
+        return JetMatrix< Cols, Rows >{ value_.transpose(), layout_, partial };
+    }
+
+    /**
+     * @brief Changes the layout to one containing the current one, inserting zero derivative
+     * columns for the new parameters.
+     *
+     * @param layout New layout, a superset of the current one
+     */
+    void extend( const LayoutPtr& layout )
+    {
+        if ( layout == layout_ )
+        {
+            return;
+        }
+        Derivative partial = Derivative::Zero( size(), layout ? layout->dim() : 0 );
+        if ( layout_ )
+        {
+            detail::addColumns( partial, *layout, partial_, *layout_, 1.0 );
+        }
+        partial_.swap( partial );
+        layout_ = layout;
+    }
+
+    /**
+     * @brief In-place addition of another matrix multiplied by a number.
+     *
+     * @param other Matrix to add to this
+     * @param scalar Multiplier of the other matrix
+     */
+    void multAndAdd( const JetMatrix& other, double scalar )
+    {
+        value_ += scalar * other.value_;
+        if ( !other.layout_ )
+        {
+            return;
+        }
+        extend( ParameterLayout::merge( layout_, other.layout_ ) );
+        detail::addColumns( partial_, *layout_, other.partial_, *other.layout_, scalar );
+    }
+
+    /**
+     * @brief In-place addition operator.
+     *
+     * @param other Matrix to add
+     * @return JetMatrix& Reference to modified object
+     */
+    JetMatrix& operator+=( const JetMatrix& other )
+    {
+        multAndAdd( other, 1.0 );
+        return *this;
+    }
+
+    /**
+     * @brief In-place subtraction operator.
+     *
+     * @param other Matrix to subtract
+     * @return JetMatrix& Reference to modified object
+     */
+    JetMatrix& operator-=( const JetMatrix& other )
+    {
+        multAndAdd( other, -1.0 );
+        return *this;
+    }
+
+    /**
+     * @brief In-place multiplication operator with a number.
+     *
+     * @param other Floating point value to multiply with
+     * @return JetMatrix& Reference to modified object
+     */
+    JetMatrix& operator*=( double other )
+    {
+        value_ *= other;
+        partial_ *= other;
+        return *this;
+    }
+
+    /**
+     * @brief In-place division operator with a number.
+     *
+     * @param other Floating point value to divide with
+     * @return JetMatrix& Reference to modified object
+     */
+    JetMatrix& operator/=( double other )
+    {
+        value_ /= other;
+        partial_ /= other;
+        return *this;
+    }
+
+    /**
+     * @brief In-place multiplication operator with a scalar, applying the product rule. The
+     * derivative of every element gets the value of the element times the scalar partials added.
+     *
+     * @param other Scalar to multiply with
+     * @return JetMatrix& Reference to modified object
+     */
+    JetMatrix& operator*=( const Scalar& other )
+    {
+        partial_ *= other.value();
+        if ( other.layout() )
+        {
+            extend( ParameterLayout::merge( layout_, other.layout() ) );
+            const Derivative source = other.partial().toDense();
+            Derivative partial = Derivative::Zero( 1, dim() );
+            detail::addColumns( partial, *layout_, source, *other.layout(), 1.0 );
+            const Eigen::Map< const Eigen::VectorXd > values{ value_.data(), size() };
+            partial_.noalias() += values * partial;
+        }
+        value_ *= other.value();
+        return *this;
+    }
+
+private:
+    /** Value matrix */
+    Value value_;
+
+    /** Derivative matrix, one row per element and one column per derivative component */
+    Derivative partial_;
+
+    /** Layout shared by all elements */
+    LayoutPtr layout_;
+};
+
+
+/**
+ * @brief Addition of two matrices.
+ *
+ * @tparam Rows Number of rows
+ * @tparam Cols Number of columns
+ * @param left Left-hand-side matrix
+ * @param right Right-hand-side matrix
+ * @return JetMatrix< Rows, Cols > Sum
+ */
+template< int Rows, int Cols >
+JetMatrix< Rows, Cols > operator+(
+    JetMatrix< Rows, Cols > left, const JetMatrix< Rows, Cols >& right )
+{
+    return left += right;
+}
+
+/**
+ * @brief Subtraction of two matrices.
+ *
+ * @tparam Rows Number of rows
+ * @tparam Cols Number of columns
+ * @param left Left-hand-side matrix
+ * @param right Right-hand-side matrix
+ * @return JetMatrix< Rows, Cols > Difference
+ */
+template< int Rows, int Cols >
+JetMatrix< Rows, Cols > operator-(
+    JetMatrix< Rows, Cols > left, const JetMatrix< Rows, Cols >& right )
+{
+    return left -= right;
+}
+
+/**
+ * @brief Negation of a matrix.
+ *
+ * @tparam Rows Number of rows
+ * @tparam Cols Number of columns
+ * @param matrix Matrix to negate
+ * @return JetMatrix< Rows, Cols > Negated matrix
+ */
+template< int Rows, int Cols >
+JetMatrix< Rows, Cols > operator-( JetMatrix< Rows, Cols > matrix )
+{
+    return matrix *= -1.0;
+}
+
+/**
+ * @brief Multiplication of a matrix by a number.
+ *
+ * @tparam Rows Number of rows
+ * @tparam Cols Number of columns
+ * @param matrix Matrix
+ * @param scalar Number
+ * @return JetMatrix< Rows, Cols > Scaled matrix
+ */
+template< int Rows, int Cols >
+JetMatrix< Rows, Cols > operator*( JetMatrix< Rows, Cols > matrix, double scalar )
+{
+    return matrix *= scalar;
+}
+
+/**
+ * @brief Multiplication of a number by a matrix.
+ *
+ * @tparam Rows Number of rows
+ * @tparam Cols Number of columns
+ * @param scalar Number
+ * @param matrix Matrix
+ * @return JetMatrix< Rows, Cols > Scaled matrix
+ */
+template< int Rows, int Cols >
+JetMatrix< Rows, Cols > operator*( double scalar, JetMatrix< Rows, Cols > matrix )
+{
+    return matrix *= scalar;
+}
+
+/**
+ * @brief Division of a matrix by a number.
+ *
+ * @tparam Rows Number of rows
+ * @tparam Cols Number of columns
+ * @param matrix Matrix
+ * @param scalar Number
+ * @return JetMatrix< Rows, Cols > Scaled matrix
+ */
+template< int Rows, int Cols >
+JetMatrix< Rows, Cols > operator/( JetMatrix< Rows, Cols > matrix, double scalar )
+{
+    return matrix /= scalar;
+}
+
+/**
+ * @brief Multiplication of a matrix by a scalar with partials.
+ *
+ * @tparam Rows Number of rows
+ * @tparam Cols Number of columns
+ * @param matrix Matrix
+ * @param scalar Scalar
+ * @return JetMatrix< Rows, Cols > Scaled matrix
+ */
+template< int Rows, int Cols >
+JetMatrix< Rows, Cols > operator*( JetMatrix< Rows, Cols > matrix, const Scalar& scalar )
+{
+    return matrix *= scalar;
+}
+
+/**
+ * @brief Multiplication of a scalar with partials by a matrix.
+ *
+ * @tparam Rows Number of rows
+ * @tparam Cols Number of columns
+ * @param scalar Scalar
+ * @param matrix Matrix
+ * @return JetMatrix< Rows, Cols > Scaled matrix
+ */
+template< int Rows, int Cols >
+JetMatrix< Rows, Cols > operator*( const Scalar& scalar, JetMatrix< Rows, Cols > matrix )
+{
+    return matrix *= scalar;
+}
+
+
+/**
+ * @brief Matrix product with derivatives. The value is a single Eigen matrix product, and the
+ * derivatives follow from the product rule d(AB) = dA B + A dB with two more products over the
+ * stacked derivative slices.
+ *
+ * The derivative slices of the RHS lie next to each other in memory, so A dB is one product of
+ * the LHS value with all slices at once, see \ref detail::timesSlice. The slices of the LHS are
+ * stacked vertically into one matrix, so that dA B is also one product with the RHS value, see
+ * \ref detail::sliceTimes.
+ *
+ * @throws std::runtime_error
+ *
+ * @tparam Rows Number of rows of the LHS
+ * @tparam Inner Number of columns of the LHS and rows of the RHS
+ * @tparam Cols Number of columns of the RHS
+ * @param left Left-hand-side matrix
+ * @param right Right-hand-side matrix
+ * @return JetMatrix< Rows, Cols > Product
+ */
+template< int Rows, int Inner, int Cols >
+JetMatrix< Rows, Cols > operator*(
+    const JetMatrix< Rows, Inner >& left, const JetMatrix< Inner, Cols >& right )
+{
+    if ( left.cols() != right.rows() )
+    {
+        throw std::runtime_error( "Error! Matrix product of incompatible sizes" );
+    }
+    const Eigen::Index rows = left.rows();
+    const Eigen::Index cols = right.cols();
+    const LayoutPtr layout = ParameterLayout::merge( left.layout(), right.layout() );
+    Eigen::MatrixXd partial = Eigen::MatrixXd::Zero( rows * cols, layout ? layout->dim() : 0 );
+
+    if ( left.dim() > 0 )
+    {
+        const Eigen::MatrixXd slices = detail::sliceTimes( left.partial(), rows, right.value() );
+        detail::addColumns( partial, *layout, slices, *left.layout(), 1.0 );
+    }
+    if ( right.dim() > 0 )
+    {
+        const Eigen::MatrixXd slices = detail::timesSlice( left.value(), right.partial(), cols );
+        detail::addColumns( partial, *layout, slices, *right.layout(), 1.0 );
+    }
+
+    return JetMatrix< Rows, Cols >{ left.value() * right.value(), layout, partial };
+}
+
+/**
+ * @brief Matrix product of two matrices of scalars with derivatives, computed as product of jet
+ * matrices, see \ref operator*( const JetMatrix< Rows, Inner >&, const JetMatrix< Inner, Cols >& ).
+ *
+ * Eigen's product of matrices of scalars builds a scalar expression for every inner product, with
+ * a parameter merge at every step. Here the partials are gathered once per operand and
+ * multiplied with dense matrix products.
+ *
+ * @throws std::runtime_error
+ *
+ * @tparam Rows Number of rows of the LHS
+ * @tparam Inner Number of columns of the LHS and rows of the RHS
+ * @tparam Cols Number of columns of the RHS
+ * @param left Left-hand-side matrix
+ * @param right Right-hand-side matrix
+ * @return MatrixT< Rows, Cols > Product
+ */
+template< int Rows, int Inner, int Cols >
+MatrixT< Rows, Cols > product(
+    const MatrixT< Rows, Inner >& left, const MatrixT< Inner, Cols >& right )
+{
+    return ( JetMatrix< Rows, Inner >{ left } * JetMatrix< Inner, Cols >{ right } ).toMatrix();
+}
+
+/**
+ * @brief Creates a jet matrix from a value matrix, with partials w.r.t. a new parameter of the
+ * dimension of the matrix size. The derivative matrix is the identity.
+ *
+ * @tparam Param Type of the parameter to create
+ * @tparam Rows Number of rows
+ * @tparam Cols Number of columns
+ * @tparam Args Types of the parameter constructor arguments, after the dimension
+ * @param value Value of the matrix
+ * @param args Parameter constructor arguments, after the dimension
+ * @return JetMatrix< Rows, Cols > Matrix containing partials
+ */
+template< typename Param, int Rows, int Cols, typename... Args >
+JetMatrix< Rows, Cols > createJet( const Eigen::Matrix< double, Rows, Cols >& value, Args... args )
+{
+    const int dim = static_cast< int >( value.size() );
+    const auto layout = ParameterLayout::create( { std::make_shared< Param >( dim, args... ) } );
+    return JetMatrix< Rows, Cols >{ value, layout, Eigen::MatrixXd::Identity( dim, dim ) };
+}
+
+
+/** Type alias for dynamic jet matrix */
+using JetMatrixX = JetMatrix< Eigen::Dynamic, Eigen::Dynamic >;
+
+/** Type alias for 6x6 jet matrix */
+using JetMatrix6 = JetMatrix< 6, 6 >;
+
+/** Type alias for N dimensional jet vector */
+template< int Rows >
+using JetVectorT = JetMatrix< Rows, 1 >;
+
+/** Type alias for 6 dimensional jet vector */
+using JetVector6 = JetVectorT< 6 >;
+
+} // metal
+
+#endif // METAL_JETMATRIX_H
@@ -0,0 +1,536 @@
+#ifndef METAL_LINEARALGEBRA_H
+#define METAL_LINEARALGEBRA_H
+
+
+#include "src/JetMatrix.h"
+
+#ifdef __clang__
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Weverything"
+#include <Eigen/Cholesky>
+#include <Eigen/LU>
+#include <Eigen/QR>
+#include <Eigen/SVD>
+#pragma clang diagnostic pop
+#elif defined __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Weffc++"
+#include <Eigen/Cholesky>
+#include <Eigen/LU>
+#include <Eigen/QR>
+#include <Eigen/SVD>
+#pragma GCC diagnostic pop
+#else
+#include <Eigen/Cholesky>
+#include <Eigen/LU>
+#include <Eigen/QR>
+#include <Eigen/SVD>
+#endif
+#include <limits>
+
+
+namespace metal
+{
+
+namespace detail
+{
+
+    /**
+     * @brief Tells whether the matrix of a partially pivoted LU decomposition is invertible in
+     * double precision, judged by the estimate of its reciprocal condition number.
+     *
+     * @tparam Value Type of the decomposed matrix
+     * @param lu Decomposition
+     * @return true The matrix is invertible
+     */
+    template< typename Value >
+    bool isInvertible( const Eigen::PartialPivLU< Value >& lu )
+    {
+        // Also false for a NaN estimate of a matrix with a zero pivot
+        return lu.rcond() > std::numeric_limits< double >::epsilon();
+    }
+
+    /**
+     * @brief Tells whether the upper triangular factor of a QR decomposition has full rank in
+     * double precision, i.e. every diagonal element exceeds the largest one in magnitude scaled by
+     * the machine epsilon and the size.
+     *
+     * @tparam Value Type of the upper triangular factor
+     * @param r Upper triangular factor
+     * @return true The factor has full rank
+     */
+    template< typename Value >
+    bool hasFullRank( const Value& r )
+    {
+        const auto diagonal = r.diagonal().array().abs();
+        if ( diagonal.size() == 0 )
+        {
+            return true;
+        }
+        const double tolerance = std::numeric_limits< double >::epsilon()
+            * static_cast< double >( diagonal.size() ) * diagonal.maxCoeff();
+        // Also false for NaN elements
+        return ( diagonal > tolerance ).all();
+    }
+
+} // detail
+
+/**
+ * @brief Solves the linear system A X = B with derivatives.
+ *
+ * The value matrix of A is factorized once with a partially pivoted LU decomposition. The
+ * derivatives follow from differentiating the system, A dX = dB - dA X, so all derivative slices
+ * are solved at once as additional right hand sides with the same factorization. The matrix A has
+ * to be invertible, a numerically singular matrix throws.
+ *
+ * @throws std::runtime_error
+ *
+ * @tparam Size Number of rows and columns of the system matrix
+ * @tparam Cols Number of columns of the right hand side
+ * @param a System matrix
+ * @param b Right hand side
+ * @return JetMatrix< Size, Cols > Solution
+ */
+template< int Size, int Cols >
+JetMatrix< Size, Cols > solve( const JetMatrix< Size, Size >& a, const JetMatrix< Size, Cols >& b )
+{
+    if ( a.rows() != a.cols() || a.rows() != b.rows() )
+    {
+        throw std::runtime_error( "Error! Linear system of incompatible sizes" );
+    }
+    const Eigen::PartialPivLU< Eigen::Matrix< double, Size, Size > > lu{ a.value() };
+    if ( !detail::isInvertible( lu ) )
+    {
+        throw std::runtime_error( "Error! Linear system with a singular matrix" );
+    }
+    const typename JetMatrix< Size, Cols >::Value x = lu.solve( b.value() );
+
+    const Eigen::Index rows = b.rows();
+    const Eigen::Index cols = b.cols();
+    const LayoutPtr layout = ParameterLayout::merge( a.layout(), b.layout() );
+    const Eigen::Index dim = layout ? layout->dim() : 0;
+    Eigen::MatrixXd rhs = Eigen::MatrixXd::Zero( rows * cols, dim );
+    if ( b.dim() > 0 )
+    {
+        detail::addColumns( rhs, *layout, b.partial(), *b.layout(), 1.0 );
+    }
+    if ( a.dim() > 0 )
+    {
+        const Eigen::MatrixXd slices = detail::sliceTimes( a.partial(), rows, x );
+        detail::addColumns( rhs, *layout, slices, *a.layout(), -1.0 );
+    }
+
+    Eigen::MatrixXd partial( rows * cols, dim );
+    if ( dim > 0 )
+    {
+        Eigen::Map< Eigen::MatrixXd >{ partial.data(), rows, cols * dim }
+            = lu.solve( Eigen::Map< const Eigen::MatrixXd >{ rhs.data(), rows, cols * dim } );
+    }
+    return JetMatrix< Size, Cols >{ x, layout, partial };
+}
+
+/**
+ * @brief Solves the linear system A X = B of matrices of scalars with derivatives, computed with
+ * jet matrices, see \ref solve( const JetMatrix< Size, Size >&, const JetMatrix< Size, Cols >& ).
+ *
+ * Eigen's decompositions of matrices of scalars carry the partials through every pivot operation.
+ * Here the partials are gathered once per operand and solved with the factorization of the values.
+ *
+ * @throws std::runtime_error
+ *
+ * @tparam Size Number of rows and columns of the system matrix
+ * @tparam Cols Number of columns of the right hand side
+ * @param a System matrix
+ * @param b Right hand side
+ * @return MatrixT< Size, Cols > Solution
+ */
+template< int Size, int Cols >
+MatrixT< Size, Cols > solve( const MatrixT< Size, Size >& a, const MatrixT< Size, Cols >& b )
+{
+    return solve( JetMatrix< Size, Size >{ a }, JetMatrix< Size, Cols >{ b } ).toMatrix();
+}
+
+namespace detail
+{
+
+    /**
+     * @brief Returns the derivatives of tr(M dA) for all derivative slices dA, which is a single
+     * product of the derivative columns with vec(M^T).
+     *
+     * @tparam Value Type of matrix M
+     * @param m Matrix multiplied by the slices
+     * @param partial Derivative columns of the slices
+     * @return EigenRowVector Derivatives of the traces
+     */
+    template< typename Value >
+    EigenRowVector traceTimes( const Eigen::MatrixBase< Value >& m, const Eigen::MatrixXd& partial )
+    {
+        const Eigen::MatrixXd transposed = m.transpose();
+        return Eigen::Map< const EigenRowVector >{ transposed.data(), transposed.size() } * partial;
+    }
+
+    /**
+     * @brief Returns the adjugate of a square matrix of any rank from its singular value
+     * decomposition A = U S V^T, as adj(A) = det(U) det(V) V adj(S) U^T. The diagonal adj(S)
+     * holds the products of all other singular values, computed without division.
+     *
+     * @tparam Value Type of the matrix
+     * @param a Square matrix
+     * @return Value Adjugate
+     */
+    template< typename Value >
+    Value adjugate( const Value& a )
+    {
+        const Eigen::JacobiSVD< Value > svd{ a, Eigen::ComputeFullU | Eigen::ComputeFullV };
+        const Eigen::VectorXd& sigma = svd.singularValues();
+        const Eigen::Index n = sigma.size();
+        Eigen::VectorXd cofactors( n );
+        double product = 1.0;
+        for ( Eigen::Index i = 0; i < n; i++ )
+        {
+            cofactors( i ) = product;
+            product *= sigma( i );
+        }
+        product = 1.0;
+        for ( Eigen::Index i = n - 1; i >= 0; i-- )
+        {
+            cofactors( i ) *= product;
+            product *= sigma( i );
+        }
+        const double sign = svd.matrixU().determinant() * svd.matrixV().determinant();
+        return sign * svd.matrixV() * cofactors.asDiagonal() * svd.matrixU().transpose();
+    }
+
+} // detail
+
+/**
+ * @brief Returns the inverse of a matrix with derivatives, d(A^-1) = -A^-1 dA A^-1.
+ *
+ * The value is inverted with one partially pivoted LU decomposition, and the derivative slices are
+ * multiplied by the inverse from both sides with two products over all slices at once. The matrix
+ * has to be invertible, a numerically singular matrix throws.
+ *
+ * @throws std::runtime_error
+ *
+ * @tparam Size Number of rows and columns
+ * @param a Matrix to invert
+ * @return JetMatrix< Size, Size > Inverse
+ */
+template< int Size >
+JetMatrix< Size, Size > inverse( const JetMatrix< Size, Size >& a )
+{
+    if ( a.rows() != a.cols() )
+    {
+        throw std::runtime_error( "Error! Inverse of a non-square matrix" );
+    }
+    const Eigen::PartialPivLU< Eigen::Matrix< double, Size, Size > > lu{ a.value() };
+    if ( !detail::isInvertible( lu ) )
+    {
+        throw std::runtime_error( "Error! Inverse of a singular matrix" );
+    }
+    const typename JetMatrix< Size, Size >::Value inv = lu.inverse();
+    if ( a.dim() == 0 )
+    {
+        return JetMatrix< Size, Size >{ inv };
+    }
+    const Eigen::MatrixXd right = detail::sliceTimes( a.partial(), a.rows(), inv );
+    return JetMatrix< Size, Size >{ inv, a.layout(), -detail::timesSlice( inv, right, a.cols() ) };
+}
+
+/**
+ * @brief Returns the determinant of a matrix with derivatives, d det(A) = tr(adj(A) dA).
+ *
+ * The value comes from one partially pivoted LU decomposition. For an invertible matrix the
+ * adjugate is det(A) A^-1 from the same decomposition. For a numerically singular matrix it is
+ * computed from a singular value decomposition instead, so the derivatives stay finite.
+ *
+ * @throws std::runtime_error
+ *
+ * @tparam Size Number of rows and columns
+ * @param a Matrix
+ * @return Scalar Determinant
+ */
+template< int Size >
+Scalar determinant( const JetMatrix< Size, Size >& a )
+{
+    if ( a.rows() != a.cols() )
+    {
+        throw std::runtime_error( "Error! Determinant of a non-square matrix" );
+    }
+    const Eigen::PartialPivLU< Eigen::Matrix< double, Size, Size > > lu{ a.value() };
+    const double det = lu.determinant();
+    if ( a.dim() == 0 )
+    {
+        return Scalar{ det };
+    }
+    if ( !detail::isInvertible( lu ) )
+    {
+        return Scalar{ det, a.layout(),
+            detail::traceTimes( detail::adjugate( a.value() ), a.partial() ) };
+    }
+    return Scalar{ det, a.layout(), det * detail::traceTimes( lu.inverse(), a.partial() ) };
+}
+
+/**
+ * @brief Returns the logarithm of the absolute determinant of a matrix with derivatives,
+ * d log|det(A)| = tr(A^-1 dA).
+ *
+ * The value is summed from the logarithms of the pivots of one partially pivoted LU decomposition,
+ * so it neither overflows nor underflows for large matrices like covariances. The matrix has to be
+ * invertible, a numerically singular matrix throws.
+ *
+ * @throws std::runtime_error
+ *
+ * @tparam Size Number of rows and columns
+ * @param a Matrix
+ * @return Scalar Logarithm of the absolute determinant
+ */
+template< int Size >
+Scalar logDeterminant( const JetMatrix< Size, Size >& a )
+{
+    if ( a.rows() != a.cols() )
+    {
+        throw std::runtime_error( "Error! Determinant of a non-square matrix" );
+    }
+    const Eigen::PartialPivLU< Eigen::Matrix< double, Size, Size > > lu{ a.value() };
+    if ( !detail::isInvertible( lu ) )
+    {
+        throw std::runtime_error( "Error! Logarithm of the determinant of a singular matrix" );
+    }
+    const double logDet = lu.matrixLU().diagonal().array().abs().log().sum();
+    if ( a.dim() == 0 )
+    {
+        return Scalar{ logDet };
+    }
+    return Scalar{ logDet, a.layout(), detail::traceTimes( lu.inverse(), a.partial() ) };
+}
+
+/**
+ * @brief Returns the inverse of a matrix of scalars with derivatives, computed with jet matrices,
+ * see \ref inverse( const JetMatrix< Size, Size >& ).
+ *
+ * @throws std::runtime_error
+ *
+ * @tparam Size Number of rows and columns
+ * @param a Matrix to invert
+ * @return MatrixT< Size, Size > Inverse
+ */
+template< int Size >
+MatrixT< Size, Size > inverse( const MatrixT< Size, Size >& a )
+{
+    return inverse( JetMatrix< Size, Size >{ a } ).toMatrix();
+}
+
+/**
+ * @brief Returns the determinant of a matrix of scalars with derivatives, computed with jet
+ * matrices, see \ref determinant( const JetMatrix< Size, Size >& ).
+ *
+ * @throws std::runtime_error
+ *
+ * @tparam Size Number of rows and columns
+ * @param a Matrix
+ * @return Scalar Determinant
+ */
+template< int Size >
+Scalar determinant( const MatrixT< Size, Size >& a )
+{
+    return determinant( JetMatrix< Size, Size >{ a } );
+}
+
+/**
+ * @brief Returns the logarithm of the absolute determinant of a matrix of scalars with
+ * derivatives, computed with jet matrices, see
+ * \ref logDeterminant( const JetMatrix< Size, Size >& ).
+ *
+ * @throws std::runtime_error
+ *
+ * @tparam Size Number of rows and columns
+ * @param a Matrix
+ * @return Scalar Logarithm of the absolute determinant
+ */
+template< int Size >
+Scalar logDeterminant( const MatrixT< Size, Size >& a )
+{
+    return logDeterminant( JetMatrix< Size, Size >{ a } );
+}
+
+/**
+ * @brief Factors of a thin QR decomposition A = Q R of a matrix with at least as many rows as
+ * columns.
+ *
+ * @tparam QMatrix Type of the factor with orthonormal columns
+ * @tparam RMatrix Type of the square upper triangular factor
+ */
+template< typename QMatrix, typename RMatrix >
+struct QRFactors
+{
+    /** Factor with orthonormal columns, of the size of the decomposed matrix */
+    QMatrix q;
+
+    /** Upper triangular factor */
+    RMatrix r;
+};
+
+/**
+ * @brief Returns the lower triangular Cholesky factor L of a symmetric positive definite matrix
+ * A = L L^T with derivatives, dL = L Phi(L^-1 dA L^-T).
+ *
+ * The value is factorized with Eigen's LLT. Phi takes the lower triangle of a matrix and halves
+ * its diagonal. Both triangular solves and the final product run over all derivative slices at
+ * once. Like the factorization of the value, only the lower triangles of the derivative slices
+ * are read, the slices are taken as symmetric.
+ *
+ * @throws std::runtime_error
+ *
+ * @tparam Size Number of rows and columns
+ * @param a Symmetric positive definite matrix
+ * @return JetMatrix< Size, Size > Lower triangular factor
+ */
+template< int Size >
+JetMatrix< Size, Size > cholesky( const JetMatrix< Size, Size >& a )
+{
+    if ( a.rows() != a.cols() )
+    {
+        throw std::runtime_error( "Error! Cholesky decomposition of a non-square matrix" );
+    }
+    const Eigen::LLT< Eigen::Matrix< double, Size, Size > > llt{ a.value() };
+    if ( llt.info() != Eigen::Success )
+    {
+        throw std::runtime_error( "Error! Cholesky decomposition of an indefinite matrix" );
+    }
+    const typename JetMatrix< Size, Size >::Value l = llt.matrixL();
+    if ( a.dim() == 0 )
+    {
+        return JetMatrix< Size, Size >{ l };
+    }
+
+    const Eigen::Index n = a.rows();
+    const Eigen::Index dim = a.dim();
+    Eigen::MatrixXd slices( n, n * dim );
+    for ( int k = 0; k < dim; k++ )
+    {
+        slices.middleCols( n * k, n ) = a.slice( k ).template selfadjointView< Eigen::Lower >();
+    }
+
+    // L^-1 dA L^-T is symmetric, so it is also L^-1 ( L^-1 dA )^T
+    l.template triangularView< Eigen::Lower >().solveInPlace( slices );
+    for ( int k = 0; k < dim; k++ )
+    {
+        slices.middleCols( n * k, n ).transposeInPlace();
+    }
+    l.template triangularView< Eigen::Lower >().solveInPlace( slices );
+    for ( int k = 0; k < dim; k++ )
+    {
+        auto slice = slices.middleCols( n * k, n );
+        slice.template triangularView< Eigen::StrictlyUpper >().setZero();
+        slice.diagonal() *= 0.5;
+    }
+
+    Eigen::MatrixXd partial( n * n, dim );
+    Eigen::Map< Eigen::MatrixXd >{ partial.data(), n, n * dim }.noalias()
+        = l.template triangularView< Eigen::Lower >() * slices;
+    return JetMatrix< Size, Size >{ l, a.layout(), partial };
+}
+
+/**
+ * @brief Returns the thin Householder QR decomposition A = Q R of a matrix of full column rank
+ * with derivatives.
+ *
+ * The value is factorized with Eigen's HouseholderQR. With C = Q^T dA R^-1, the derivative of the
+ * upper triangular factor is dR = U R and the derivative of the orthonormal factor is
+ * dQ = dA R^-1 - Q U, where U is the upper triangle of C plus the transposed strictly lower
+ * triangle of C. All products run over all derivative slices at once.
+ *
+ * @throws std::runtime_error
+ *
+ * @tparam Rows Number of rows, at least the number of columns
+ * @tparam Cols Number of columns
+ * @param a Matrix of full column rank
+ * @return QRFactors< JetMatrix< Rows, Cols >, JetMatrix< Cols, Cols > > Factors
+ */
+template< int Rows, int Cols >
+QRFactors< JetMatrix< Rows, Cols >, JetMatrix< Cols, Cols > > qr( const JetMatrix< Rows, Cols >& a )
+{
+    using Factors = QRFactors< JetMatrix< Rows, Cols >, JetMatrix< Cols, Cols > >;
+    using QValue = typename JetMatrix< Rows, Cols >::Value;
+    using RValue = typename JetMatrix< Cols, Cols >::Value;
+
+    const Eigen::Index m = a.rows();
+    const Eigen::Index n = a.cols();
+    if ( m < n )
+    {
+        throw std::runtime_error( "Error! QR decomposition of a wide matrix" );
+    }
+    const Eigen::HouseholderQR< QValue > householder{ a.value() };
+    const QValue q = householder.householderQ() * QValue::Identity( m, n );
+    const RValue r = householder.matrixQR().topRows( n ).template triangularView< Eigen::Upper >();
+    if ( a.dim() == 0 )
+    {
+        return Factors{ JetMatrix< Rows, Cols >{ q }, JetMatrix< Cols, Cols >{ r } };
+    }
+    if ( !detail::hasFullRank( r ) )
+    {
+        throw std::runtime_error( "Error! QR derivatives of a matrix without full column rank" );
+    }
+
+    const RValue rInv
+        = r.template triangularView< Eigen::Upper >().solve( RValue::Identity( n, n ) );
+    const Eigen::MatrixXd dAR = detail::sliceTimes( a.partial(), m, rInv );
+    Eigen::MatrixXd u = detail::timesSlice( q.transpose(), dAR, n );
+    for ( Eigen::Index k = 0; k < u.cols(); k++ )
+    {
+        Eigen::Map< Eigen::MatrixXd > slice{ u.col( k ).data(), n, n };
+        for ( Eigen::Index j = 0; j < n; j++ )
+        {
+            for ( Eigen::Index i = 0; i < j; i++ )
+            {
+                slice( i, j ) += slice( j, i );
+                slice( j, i ) = 0.0;
+            }
+        }
+    }
+
+    return Factors{ JetMatrix< Rows, Cols >{ q, a.layout(), dAR - detail::timesSlice( q, u, n ) },
+        JetMatrix< Cols, Cols >{ r, a.layout(), detail::sliceTimes( u, n, r ) } };
+}
+
+/**
+ * @brief Returns the lower triangular Cholesky factor of a symmetric positive definite matrix of
+ * scalars with derivatives, computed with jet matrices, see
+ * \ref cholesky( const JetMatrix< Size, Size >& ).
+ *
+ * @throws std::runtime_error
+ *
+ * @tparam Size Number of rows and columns
+ * @param a Symmetric positive definite matrix
+ * @return MatrixT< Size, Size > Lower triangular factor
+ */
+template< int Size >
+MatrixT< Size, Size > cholesky( const MatrixT< Size, Size >& a )
+{
+    return cholesky( JetMatrix< Size, Size >{ a } ).toMatrix();
+}
+
+/**
+ * @brief Returns the thin QR decomposition of a matrix of scalars with derivatives, computed with
+ * jet matrices, see \ref qr( const JetMatrix< Rows, Cols >& ).
+ *
+ * @throws std::runtime_error
+ *
+ * @tparam Rows Number of rows, at least the number of columns
+ * @tparam Cols Number of columns
+ * @param a Matrix of full column rank
+ * @return QRFactors< MatrixT< Rows, Cols >, MatrixT< Cols, Cols > > Factors
+ */
+template< int Rows, int Cols >
+QRFactors< MatrixT< Rows, Cols >, MatrixT< Cols, Cols > > qr( const MatrixT< Rows, Cols >& a )
+{
+    const QRFactors< JetMatrix< Rows, Cols >, JetMatrix< Cols, Cols > > factors
+        = qr( JetMatrix< Rows, Cols >{ a } );
+    return QRFactors< MatrixT< Rows, Cols >, MatrixT< Cols, Cols > >{
+        factors.q.toMatrix(), factors.r.toMatrix() };
+}
+
+} // metal
+
+#endif // METAL_LINEARALGEBRA_H
@@ -58,6 +58,49 @@ struct NumTraits< metal::Scalar > : NumTraits< double >
     };
 };
 
+/**
+ * @brief This template specialization of the Eigen num traits object is allowing the ScalarN
+ * object to be used as the scalar template parameter for Eigen vectors and matrices.
+ *
+ * @tparam N Dimension of the partial derivative vector
+ */
+template< int N >
+struct NumTraits< metal::ScalarN< N > > : NumTraits< metal::Scalar >
+{
+    /** Alias for real type */
+    using Real = metal::ScalarN< N >;
+
+    /** Alias for non-integer type */
+    using NonInteger = metal::ScalarN< N >;
+
+    /** Alias for nested type */
+    using Nested = metal::ScalarN< N >;
+
+    /** Alias for literal type */
+    using Literal = metal::ScalarN< N >;
+};
+
+/**
+ * @brief This template specialization of the Eigen num traits object is allowing the ValueScalar
+ * object to be used as the scalar template parameter for Eigen vectors and matrices. The costs
+ * are the ones of double.
+ */
+template<>
+struct NumTraits< metal::ValueScalar > : NumTraits< double >
+{
+    /** Alias for real type */
+    using Real = metal::ValueScalar;
+
+    /** Alias for non-integer type */
+    using NonInteger = metal::ValueScalar;
+
+    /** Alias for nested type */
+    using Nested = metal::ValueScalar;
+
+    /** Alias for literal type */
+    using Literal = metal::ValueScalar;
+};
+
 /**
  * @brief Template specialization for determining the result type of a binary operation between
  * Scalar object and a floating point number. It is defined for any kind of binary operation.
@@ -84,6 +127,60 @@ struct ScalarBinaryOpTraits< double, metal::Scalar, BinaryOp >
     using ReturnType = metal::Scalar;
 };
 
+/**
+ * @brief Template specialization for determining the result type of a binary operation between
+ * ScalarN object and a floating point number. It is defined for any kind of binary operation.
+ *
+ * @tparam N Dimension of the partial derivative vector
+ * @tparam BinaryOp Type of the binary operation
+ */
+template< int N, typename BinaryOp >
+struct ScalarBinaryOpTraits< metal::ScalarN< N >, double, BinaryOp >
+{
+    /** Alias for return type */
+    using ReturnType = metal::ScalarN< N >;
+};
+
+/**
+ * @brief Template specialization for determining the result type of a binary operation between
+ * floating point number and a ScalarN object. It is defined for any kind of binary operation.
+ *
+ * @tparam N Dimension of the partial derivative vector
+ * @tparam BinaryOp Type of the binary operation
+ */
+template< int N, typename BinaryOp >
+struct ScalarBinaryOpTraits< double, metal::ScalarN< N >, BinaryOp >
+{
+    /** Alias for return type */
+    using ReturnType = metal::ScalarN< N >;
+};
+
+/**
+ * @brief Template specialization for determining the result type of a binary operation between
+ * ValueScalar object and a floating point number. It is defined for any kind of binary operation.
+ *
+ * @tparam BinaryOp Type of the binary operation
+ */
+template< typename BinaryOp >
+struct ScalarBinaryOpTraits< metal::ValueScalar, double, BinaryOp >
+{
+    /** Alias for return type */
+    using ReturnType = metal::ValueScalar;
+};
+
+/**
+ * @brief Template specialization for determining the result type of a binary operation between
+ * floating point number and a ValueScalar object. It is defined for any kind of binary operation.
+ *
+ * @tparam BinaryOp Type of the binary operation
+ */
+template< typename BinaryOp >
+struct ScalarBinaryOpTraits< double, metal::ValueScalar, BinaryOp >
+{
+    /** Alias for return type */
+    using ReturnType = metal::ValueScalar;
+};
+
 } // Eigen
 
 
@@ -116,6 +213,14 @@ using Vector3 = VectorT< 3 >;
 /** Type alias for 6 dimensional vector */
 using Vector6 = VectorT< 6 >;
 
+/** Type alias for NxM matrix with partials of fixed dimension D */
+template< int D, int Rows, int Cols >
+using MatrixNT = Eigen::Matrix< metal::ScalarN< D >, Rows, Cols >;
+
+/** Type alias for N dimensional vector with partials of fixed dimension D */
+template< int D, int Rows >
+using VectorNT = MatrixNT< D, Rows, 1 >;
+
 
 /**
  * @brief Creates a metal matrix vaiable from an Eigen matrix variable including the partial
@@ -170,6 +275,40 @@ MatrixT< Rows, Cols > create(
     return out;
 }
 
+/**
+ * @brief Creates a metal matrix variable with fixed dimension partials from a fixed size Eigen
+ * matrix variable. The partial derivatives refer to the parameter created using the provided
+ * arguments, which has the dimension of the matrix size.
+ *
+ * @tparam Param Type of the parameter to create
+ * @tparam Rows Number of rows of the input/output matrix
+ * @tparam Cols Number of columns of the input/output matrix
+ * @tparam Args Types of the parameter constructor arguments, after the dimension
+ * @param value Value of the matrix
+ * @param args Parameter constructor arguments, after the dimension
+ * @return MatrixNT< Rows * Cols, Rows, Cols > Matrix containing partials
+ */
+template< typename Param, int Rows, int Cols, typename... Args >
+MatrixNT< Rows * Cols, Rows, Cols > createN(
+    const Eigen::Matrix< double, Rows, Cols >& value, Args... args )
+{
+    using ScalarType = metal::ScalarN< Rows * Cols >;
+    using Partial = typename ScalarType::Partial;
+    const auto layout
+        = ParameterLayout::create( { std::make_shared< Param >( Rows * Cols, args... ) } );
+
+    MatrixNT< Rows * Cols, Rows, Cols > out;
+    for ( int i = 0; i < Rows; i++ )
+    {
+        for ( int j = 0; j < Cols; j++ )
+        {
+            const Partial partial = Partial::Unit( j * Rows + i );
+            out( i, j ) = ScalarType{ value( i, j ), layout, partial };
+        }
+    }
+    return out;
+}
+
 } // metal
 
 
@@ -184,8 +323,8 @@ MatrixT< Rows, Cols > create(
  * @return std::ostream& Modified output stream
  */
 template< typename Derived,
-    typename T = typename std::enable_if<
-        std::is_same< typename Derived::Scalar, metal::Scalar >::value >::type >
+    typename T = typename std::enable_if< std::is_base_of<
+        metal::ScalarBase< typename Derived::Scalar >, typename Derived::Scalar >::value >::type >
 std::ostream& operator<<( std::ostream& os, const Eigen::MatrixBase< Derived >& vec )
 {
     metal::ParameterPtrVector params;
@@ -194,7 +333,8 @@ std::ostream& operator<<( std::ostream& os, const Eigen::MatrixBase< Derived >&
         const auto& p = vec[i].parameters();
         params.insert( params.end(), p.begin(), p.end() );
     }
-    std::sort( params.begin(), params.end() );
+    std::sort( params.begin(), params.end(),
+        []( const metal::ParameterPtr& l, const metal::ParameterPtr& r ) { return l->id() < r->id(); } );
     params.erase( std::unique( params.begin(), params.end() ), params.end() );
 
     const int prec = static_cast< int >( os.precision() );
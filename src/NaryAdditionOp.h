@@ -0,0 +1,182 @@
+#ifndef METAL_NARYADDITIONOP_H
+#define METAL_NARYADDITIONOP_H
+
+
+#include "src/BinaryAdditionOp.h"
+#include "src/BinarySubtractionOp.h"
+#include "src/ScalarNaryOp.h"
+
+
+namespace metal
+{
+
+/**
+ * @brief N-ary operation taken by \ref ScalarNaryOp object to define the expression for a
+ * weighted sum of expressions, where every operand is added or subtracted.
+ *
+ */
+struct NaryAdditionOp
+{
+    /**
+     * @brief Computes the value of the sum extended by one operand.
+     *
+     * @param value Value of the sum
+     * @param operand Value of the new operand
+     * @param weight Sign of the new operand
+     * @return double New value
+     */
+    static double combine( double value, double operand, double weight )
+    {
+        return value + weight * operand;
+    }
+
+    /**
+     * @brief Computes the factor applied to the partials w.r.t. the existing operands.
+     *
+     * @return double Factor
+     */
+    static double scale( double )
+    {
+        return 1.0;
+    }
+
+    /**
+     * @brief Computes the partial w.r.t. the new operand.
+     *
+     * @param weight Sign of the new operand
+     * @return double Partial w.r.t. the new operand
+     */
+    static double partial( double, double weight )
+    {
+        return weight;
+    }
+};
+
+
+/**
+ * @brief Addition operator extending a binary addition by another expression, creating a flat
+ * sum of the three expressions.
+ *
+ * @tparam Left Type of the LHS expression of the binary addition
+ * @tparam Right Type of the RHS expression of the binary addition
+ * @tparam Expr Type of the expression to add
+ * @param left Binary addition
+ * @param right Expression to add
+ * @return ScalarNaryOp< NaryAdditionOp, Left, Right, Expr > Expression that represents the sum
+ */
+template< typename Left, typename Right, typename Expr >
+ScalarNaryOp< NaryAdditionOp, Left, Right, Expr > operator+(
+    const ScalarBinaryOp< Left, Right, BinaryAdditionOp >& left, const ScalarBase< Expr >& right )
+{
+    return detail::flatten< NaryAdditionOp >( left ).append(
+        static_cast< const Expr& >( right ), 1.0 );
+}
+
+/**
+ * @brief Subtraction operator extending a binary addition by another expression, creating a flat
+ * sum of the three expressions.
+ *
+ * @tparam Left Type of the LHS expression of the binary addition
+ * @tparam Right Type of the RHS expression of the binary addition
+ * @tparam Expr Type of the expression to subtract
+ * @param left Binary addition
+ * @param right Expression to subtract
+ * @return ScalarNaryOp< NaryAdditionOp, Left, Right, Expr > Expression that represents the sum
+ */
+template< typename Left, typename Right, typename Expr >
+ScalarNaryOp< NaryAdditionOp, Left, Right, Expr > operator-(
+    const ScalarBinaryOp< Left, Right, BinaryAdditionOp >& left, const ScalarBase< Expr >& right )
+{
+    return detail::flatten< NaryAdditionOp >( left ).append(
+        static_cast< const Expr& >( right ), -1.0 );
+}
+
+/**
+ * @brief Addition operator extending a binary subtraction by another expression, creating a flat
+ * sum of the three expressions.
+ *
+ * @tparam Left Type of the LHS expression of the binary subtraction
+ * @tparam Right Type of the RHS expression of the binary subtraction
+ * @tparam Expr Type of the expression to add
+ * @param left Binary subtraction
+ * @param right Expression to add
+ * @return ScalarNaryOp< NaryAdditionOp, Left, Right, Expr > Expression that represents the sum
+ */
+template< typename Left, typename Right, typename Expr >
+ScalarNaryOp< NaryAdditionOp, Left, Right, Expr > operator+(
+    const ScalarBinaryOp< Left, Right, BinarySubtractionOp >& left,
+    const ScalarBase< Expr >& right )
+{
+    return detail::flatten< NaryAdditionOp >( left ).append(
+        static_cast< const Expr& >( right ), 1.0 );
+}
+
+/**
+ * @brief Subtraction operator extending a binary subtraction by another expression, creating a
+ * flat sum of the three expressions.
+ *
+ * @tparam Left Type of the LHS expression of the binary subtraction
+ * @tparam Right Type of the RHS expression of the binary subtraction
+ * @tparam Expr Type of the expression to subtract
+ * @param left Binary subtraction
+ * @param right Expression to subtract
+ * @return ScalarNaryOp< NaryAdditionOp, Left, Right, Expr > Expression that represents the sum
+ */
+template< typename Left, typename Right, typename Expr >
+ScalarNaryOp< NaryAdditionOp, Left, Right, Expr > operator-(
+    const ScalarBinaryOp< Left, Right, BinarySubtractionOp >& left,
+    const ScalarBase< Expr >& right )
+{
+    return detail::flatten< NaryAdditionOp >( left ).append(
+        static_cast< const Expr& >( right ), -1.0 );
+}
+
+/**
+ * @brief Addition operator extending a flat sum by another expression.
+ *
+ * @tparam Exprs Types of the operands of the sum
+ * @tparam Expr Type of the expression to add
+ * @param left Flat sum
+ * @param right Expression to add
+ * @return ScalarNaryOp< NaryAdditionOp, Exprs..., Expr > Expression that represents the sum
+ */
+template< typename... Exprs, typename Expr >
+ScalarNaryOp< NaryAdditionOp, Exprs..., Expr > operator+(
+    const ScalarNaryOp< NaryAdditionOp, Exprs... >& left, const ScalarBase< Expr >& right )
+{
+    return left.append( static_cast< const Expr& >( right ), 1.0 );
+}
+
+/**
+ * @brief Subtraction operator extending a flat sum by another expression.
+ *
+ * @tparam Exprs Types of the operands of the sum
+ * @tparam Expr Type of the expression to subtract
+ * @param left Flat sum
+ * @param right Expression to subtract
+ * @return ScalarNaryOp< NaryAdditionOp, Exprs..., Expr > Expression that represents the sum
+ */
+template< typename... Exprs, typename Expr >
+ScalarNaryOp< NaryAdditionOp, Exprs..., Expr > operator-(
+    const ScalarNaryOp< NaryAdditionOp, Exprs... >& left, const ScalarBase< Expr >& right )
+{
+    return left.append( static_cast< const Expr& >( right ), -1.0 );
+}
+
+/**
+ * @brief Sum of any number of expressions, built as one flat node without the intermediate nodes
+ * of a chain of additions.
+ *
+ * @tparam Exprs Types of the expressions
+ * @param exprs Expressions to add
+ * @return ScalarNaryOp< NaryAdditionOp, Exprs... > Expression that represents the sum
+ */
+template< typename... Exprs >
+ScalarNaryOp< NaryAdditionOp, Exprs... > sum( const ScalarBase< Exprs >&... exprs )
+{
+    return ScalarNaryOp< NaryAdditionOp, Exprs... >{ static_cast< const Exprs& >( exprs )... };
+}
+
+} // metal
+
+#endif // METAL_NARYADDITIONOP_H
@@ -0,0 +1,109 @@
+#ifndef METAL_NARYMULTIPLYOP_H
+#define METAL_NARYMULTIPLYOP_H
+
+
+#include "src/BinaryMultiplyOp.h"
+#include "src/ScalarNaryOp.h"
+
+
+namespace metal
+{
+
+/**
+ * @brief N-ary operation taken by \ref ScalarNaryOp object to define the expression for a
+ * product of expressions.
+ *
+ * The partial w.r.t. every operand is the product of all other operands, which is updated by
+ * multiplication when an operand is appended, so no division by the operand values is needed.
+ */
+struct NaryMultiplyOp
+{
+    /**
+     * @brief Computes the value of the product extended by one operand.
+     *
+     * @param value Value of the product
+     * @param operand Value of the new operand
+     * @return double New value
+     */
+    static double combine( double value, double operand, double )
+    {
+        return value * operand;
+    }
+
+    /**
+     * @brief Computes the factor applied to the partials w.r.t. the existing operands.
+     *
+     * @param operand Value of the new operand
+     * @return double Factor
+     */
+    static double scale( double operand )
+    {
+        return operand;
+    }
+
+    /**
+     * @brief Computes the partial w.r.t. the new operand.
+     *
+     * @param value Value of the product before appending the operand
+     * @return double Partial w.r.t. the new operand
+     */
+    static double partial( double value, double )
+    {
+        return value;
+    }
+};
+
+
+/**
+ * @brief Multiplication operator extending a binary multiplication by another expression,
+ * creating a flat product of the three expressions.
+ *
+ * @tparam Left Type of the LHS expression of the binary multiplication
+ * @tparam Right Type of the RHS expression of the binary multiplication
+ * @tparam Expr Type of the expression to multiply with
+ * @param left Binary multiplication
+ * @param right Expression to multiply with
+ * @return ScalarNaryOp< NaryMultiplyOp, Left, Right, Expr > Expression that represents the
+ * product
+ */
+template< typename Left, typename Right, typename Expr >
+ScalarNaryOp< NaryMultiplyOp, Left, Right, Expr > operator*(
+    const ScalarBinaryOp< Left, Right, BinaryMultiplyOp >& left, const ScalarBase< Expr >& right )
+{
+    return detail::flatten< NaryMultiplyOp >( left ).append(
+        static_cast< const Expr& >( right ), 1.0 );
+}
+
+/**
+ * @brief Multiplication operator extending a flat product by another expression.
+ *
+ * @tparam Exprs Types of the operands of the product
+ * @tparam Expr Type of the expression to multiply with
+ * @param left Flat product
+ * @param right Expression to multiply with
+ * @return ScalarNaryOp< NaryMultiplyOp, Exprs..., Expr > Expression that represents the product
+ */
+template< typename... Exprs, typename Expr >
+ScalarNaryOp< NaryMultiplyOp, Exprs..., Expr > operator*(
+    const ScalarNaryOp< NaryMultiplyOp, Exprs... >& left, const ScalarBase< Expr >& right )
+{
+    return left.append( static_cast< const Expr& >( right ), 1.0 );
+}
+
+/**
+ * @brief Product of any number of expressions, built as one flat node without the intermediate
+ * nodes of a chain of multiplications.
+ *
+ * @tparam Exprs Types of the expressions
+ * @param exprs Expressions to multiply
+ * @return ScalarNaryOp< NaryMultiplyOp, Exprs... > Expression that represents the product
+ */
+template< typename... Exprs >
+ScalarNaryOp< NaryMultiplyOp, Exprs... > product( const ScalarBase< Exprs >&... exprs )
+{
+    return ScalarNaryOp< NaryMultiplyOp, Exprs... >{ static_cast< const Exprs& >( exprs )... };
+}
+
+} // metal
+
+#endif // METAL_NARYMULTIPLYOP_H
@@ -2,6 +2,8 @@
 #define METAL_PARAMETER_H
 
 
+#include <atomic>
+#include <cstddef>
 #include <map>
 #include <memory>
 #include <string>
@@ -11,14 +13,102 @@
 namespace metal
 {
 
+/** Alias for the integer identifier of a parameter */
+using ParameterId = std::size_t;
+
+
+/**
+ * @brief Registry handing out dense, creation-ordered integer identifiers to parameters.
+ *
+ * The identifiers are used as keys in the hot paths of the derivative computation, so that no
+ * shared pointers need to be copied or compared there, and the canonical order of the parameters
+ * is deterministic between runs.
+ */
+class ParameterRegistry
+{
+
+public:
+    /**
+     * @brief Returns the single registry instance.
+     *
+     * @return ParameterRegistry& Registry
+     */
+    static ParameterRegistry& instance()
+    {
+        static ParameterRegistry registry;
+        return registry;
+    }
+
+    /**
+     * @brief Returns a new identifier, larger than all previous ones. Thread-safe.
+     *
+     * @return ParameterId New identifier
+     */
+    ParameterId acquire()
+    {
+        return next_++;
+    }
+
+    /**
+     * @brief Returns the number of identifiers handed out so far.
+     *
+     * @return ParameterId Number of identifiers
+     */
+    ParameterId count() const
+    {
+        return next_;
+    }
+
+private:
+    ParameterRegistry()
+        : next_{ 0 }
+    {
+    }
+
+    /** Next identifier to hand out */
+    std::atomic< ParameterId > next_;
+};
+
+
 /**
  * @brief Parameter pure abstract interface for which partial derivative is computed.
  *
+ * Every parameter object receives a unique identifier from the \ref ParameterRegistry at
+ * construction. Copies are new parameters with their own identifier.
+ *
  */
 class Parameter
 {
 
 public:
+    /**
+     * @brief Construct a new Parameter object with a new identifier.
+     *
+     */
+    Parameter()
+        : id_{ ParameterRegistry::instance().acquire() }
+    {
+    }
+
+    /**
+     * @brief Construct a new Parameter object as a copy, with a new identifier.
+     *
+     */
+    Parameter( const Parameter& )
+        : Parameter{}
+    {
+    }
+
+    /**
+     * @brief Assignment keeps the identifier of the parameter.
+     *
+     * @return Parameter& Reference to this object
+     */
+    Parameter& operator=( const Parameter& )
+    {
+        return *this;
+    }
+
     /**
      * @brief Destroy the Parameter object
      * 
@@ -38,6 +128,21 @@ public:
      * @return const std::string& Name of the parameter
      */
     virtual const std::string& name() const = 0;
+
+    /**
+     * @brief Returns the unique identifier of the parameter. Parameters created earlier have
+     * smaller identifiers.
+     *
+     * @return ParameterId Identifier of the parameter
+     */
+    ParameterId id() const
+    {
+        return id_;
+    }
+
+private:
+    /** Unique identifier of the parameter */
+    ParameterId id_;
 };
 
 
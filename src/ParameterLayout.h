@@ -0,0 +1,546 @@
+#ifndef METAL_PARAMETERLAYOUT_H
+#define METAL_PARAMETERLAYOUT_H
+
+
+#include "src/Parameter.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <unordered_map>
+
+
+namespace metal
+{
+
+class ParameterLayout;
+
+/**
+ * @brief Alias for shared pointer of an immutable parameter layout. A null pointer represents the
+ * empty layout (no parameters).
+ */
+using LayoutPtr = std::shared_ptr< const ParameterLayout >;
+
+
+/**
+ * @brief Immutable description of a partial derivative vector: the canonically ordered
+ * parameters, their offsets in the vector and the total dimension.
+ *
+ * The canonical order is the order of the parameter identifiers, i.e. the creation order of the
+ * parameters. Lookups and merging work on the identifiers, the shared pointers are only kept for
+ * ownership.
+ *
+ * Layouts are hash-consed per thread, meaning that a thread only ever creates one live layout
+ * object for the same set of parameters. Equal layout pointers therefore mean the same layout,
+ * which is the fast path of every operation. Layouts created by different threads for the same
+ * parameters may be different objects, so unequal pointers are resolved by the identifiers.
+ */
+class ParameterLayout
+{
+
+public:
+    /**
+     * @brief Returns the unique layout object of a set of parameters. The order of the input
+     * does not matter and duplicates are removed.
+     *
+     * @param params Parameters of the layout
+     * @return LayoutPtr Shared layout, or null pointer for empty input
+     */
+    static LayoutPtr create( const ParameterPtrVector& params );
+
+    /**
+     * @brief Returns the unique layout object of the union of several layouts. Only the
+     * identifiers are merged and looked up, the parameters are collected only if there is no live
+     * layout of the union yet.
+     *
+     * @param layouts Layouts to merge, null pointers are ignored
+     * @return LayoutPtr Union layout, the largest input if it contains all others
+     */
+    static LayoutPtr merge( const std::vector< const LayoutPtr* >& layouts );
+
+    /**
+     * @brief Returns the unique layout object of the union of two layouts.
+     *
+     * @param left First layout to merge, may be null
+     * @param right Second layout to merge, may be null
+     * @return LayoutPtr Union layout, one of the inputs if it contains the other
+     */
+    static LayoutPtr merge( const LayoutPtr& left, const LayoutPtr& right );
+
+    /**
+     * @brief Number of parameters and total dimension of a layout.
+     *
+     */
+    struct Extent
+    {
+        /** Number of parameters */
+        size_t size;
+
+        /** Total dimension */
+        int dim;
+    };
+
+    /**
+     * @brief Returns the number of parameters and the total dimension of the union of several
+     * layouts. Only the identifiers and dimensions are merged, no layout is created or looked up.
+     *
+     * @param layouts Layouts to merge, null pointers are ignored
+     * @return Extent Extent of the union layout
+     */
+    static Extent extent( const std::vector< const LayoutPtr* >& layouts );
+
+    /**
+     * @brief Returns the parameters in canonical order.
+     *
+     * @return const ParameterPtrVector& Vector of parameters
+     */
+    const ParameterPtrVector& parameters() const
+    {
+        return parameters_;
+    }
+
+    /**
+     * @brief Returns the number of parameters.
+     *
+     * @return size_t Number of parameters
+     */
+    size_t size() const
+    {
+        return parameters_.size();
+    }
+
+    /**
+     * @brief Returns the total dimension of the partial vector.
+     *
+     * @return int Sum of the parameter dimensions
+     */
+    int dim() const
+    {
+        return offsets_.back();
+    }
+
+    /**
+     * @brief Returns the dimension of a parameter.
+     *
+     * @param index Position of the parameter in the layout
+     * @return int Dimension of the parameter
+     */
+    int dim( size_t index ) const
+    {
+        return offsets_[index + 1] - offsets_[index];
+    }
+
+    /**
+     * @brief Returns the offset of a parameter in the partial vector.
+     *
+     * @param index Position of the parameter in the layout
+     * @return int Offset of the parameter
+     */
+    int offset( size_t index ) const
+    {
+        return offsets_[index];
+    }
+
+    /**
+     * @brief Returns the offset of a parameter in the partial vector.
+     *
+     * @param p Parameter to look up
+     * @return int Offset of the parameter, negative if not present in the layout
+     */
+    int offset( const ParameterPtr& p ) const
+    {
+        if ( !p )
+        {
+            return -1;
+        }
+        const auto it = std::lower_bound( ids_.begin(), ids_.end(), p->id() );
+        if ( it == ids_.end() || *it != p->id() )
+        {
+            return -1;
+        }
+        return offsets_[static_cast< size_t >( it - ids_.begin() )];
+    }
+
+    /**
+     * @brief Returns the identifier of a parameter.
+     *
+     * @param index Position of the parameter in the layout
+     * @return ParameterId Identifier of the parameter
+     */
+    ParameterId id( size_t index ) const
+    {
+        return ids_[index];
+    }
+
+    /**
+     * @brief Returns the position of the first parameter with an identifier not less than the
+     * given one.
+     *
+     * @param id Identifier to look up
+     * @return size_t Position of the parameter, the number of parameters if there is none
+     */
+    size_t find( ParameterId id ) const
+    {
+        const auto it = std::lower_bound( ids_.begin(), ids_.end(), id );
+        return static_cast< size_t >( it - ids_.begin() );
+    }
+
+    /**
+     * @brief Returns the identifiers of the parameters in canonical (increasing) order.
+     *
+     * @return const std::vector< ParameterId >& Vector of identifiers
+     */
+    const std::vector< ParameterId >& ids() const
+    {
+        return ids_;
+    }
+
+    /**
+     * @brief Checks for existance of a parameter in the layout.
+     *
+     * @param id Identifier of the parameter to check existance of
+     * @return true Parameter is part of the layout
+     * @return false Parameter is not part of the layout
+     */
+    bool contains( ParameterId id ) const
+    {
+        return std::binary_search( ids_.begin(), ids_.end(), id );
+    }
+
+    /**
+     * @brief Checks for existance of a parameter in the layout.
+     *
+     * @param p Parameter to check existance of
+     * @return true Parameter is part of the layout
+     * @return false Parameter is not part of the layout
+     */
+    bool contains( const ParameterPtr& p ) const
+    {
+        return p && contains( p->id() );
+    }
+
+    /**
+     * @brief Returns the hash of the parameters, used for interning.
+     *
+     * @return size_t Hash value
+     */
+    size_t hash() const
+    {
+        return hash_;
+    }
+
+    /**
+     * @brief Canonical ordering of the parameters by their identifiers.
+     *
+     */
+    struct Less
+    {
+        bool operator()( const ParameterPtr& left, const ParameterPtr& right ) const
+        {
+            return left->id() < right->id();
+        }
+    };
+
+private:
+    friend class LayoutRegistry;
+
+    /**
+     * @brief Returns the distinct non-null layouts of several ones.
+     *
+     * @param layouts Layouts, null pointers are ignored
+     * @return std::vector< const ParameterLayout* > Distinct layouts, ordered by address
+     */
+    static std::vector< const ParameterLayout* > distinct(
+        const std::vector< const LayoutPtr* >& layouts );
+
+    /**
+     * @brief Construct a new Parameter Layout object from canonically ordered parameters.
+     *
+     * @param params Sorted and unique parameters
+     * @param hash Hash value of the parameters
+     */
+    ParameterLayout( ParameterPtrVector params, std::vector< ParameterId > ids, size_t hash )
+        : parameters_( std::move( params ) )
+        , ids_( std::move( ids ) )
+        , offsets_( parameters_.size() + 1, 0 )
+        , hash_{ hash }
+    {
+        for ( size_t i = 0; i < parameters_.size(); i++ )
+        {
+            offsets_[i + 1] = offsets_[i] + parameters_[i]->dim();
+        }
+    }
+
+    /**
+     * @brief Computes the hash value of canonically ordered parameter identifiers.
+     *
+     * @param ids Sorted and unique identifiers
+     * @return size_t Hash value
+     */
+    static size_t hash( const std::vector< ParameterId >& ids )
+    {
+        size_t seed = ids.size();
+        for ( const auto id : ids )
+        {
+            seed ^= std::hash< ParameterId >{}( id ) + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 );
+        }
+        return seed;
+    }
+
+    /** Parameters in canonical order */
+    ParameterPtrVector parameters_;
+
+    /** Identifiers of the parameters in canonical order */
+    std::vector< ParameterId > ids_;
+
+    /** Offset of each parameter, with the total dimension as last element */
+    std::vector< int > offsets_;
+
+    /** Hash value of the parameters */
+    size_t hash_;
+};
+
+
+/**
+ * @brief Thread-local registry of the live layout objects, used to hash-cons them without
+ * locking.
+ *
+ * Layouts are shared between threads, so the registry only holds non-owning references. A layout
+ * may be destroyed on another thread or after its registry, so the references of released layouts
+ * are not removed on destruction but pruned when the registry grows.
+ *
+ * The layouts created last are also kept alive by the registry. The result layout of an
+ * expression evaluated in a loop is typically released before the next evaluation, which then
+ * finds it again instead of creating it.
+ */
+class LayoutRegistry
+{
+
+public:
+    /**
+     * @brief Returns the registry of the current thread.
+     *
+     * @return LayoutRegistry& Registry
+     */
+    static LayoutRegistry& instance()
+    {
+        static thread_local LayoutRegistry registry;
+        return registry;
+    }
+
+    /**
+     * @brief Returns the layout object for canonically ordered parameter identifiers, creating it
+     * if there is no live layout with the same identifiers.
+     *
+     * @tparam Collect Type of the function returning the parameters
+     * @param ids Sorted and unique identifiers
+     * @param collect Function returning the parameters of the identifiers in canonical order,
+     * only called if a new layout is created
+     * @return LayoutPtr Shared layout
+     */
+    template< typename Collect >
+    LayoutPtr intern( std::vector< ParameterId > ids, const Collect& collect )
+    {
+        const size_t hash = ParameterLayout::hash( ids );
+        // Released layouts of the same hash are removed, as temporary layouts are often
+        // released and created again with the same parameters
+        const auto range = entries_.equal_range( hash );
+        for ( auto it = range.first; it != range.second; )
+        {
+            LayoutPtr layout = it->second.lock();
+            if ( !layout )
+            {
+                it = entries_.erase( it );
+            }
+            else if ( layout->ids() == ids )
+            {
+                return layout;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        if ( entries_.size() >= pruneSize_ )
+        {
+            prune();
+        }
+        const LayoutPtr layout{ new ParameterLayout{ collect(), std::move( ids ), hash } };
+        entries_.emplace( hash, layout );
+        recent_[next_++ % RecentSize] = layout;
+        return layout;
+    }
+
+private:
+    LayoutRegistry() = default;
+
+    /**
+     * @brief Removes the references of released layouts, and sets the next size to prune at to
+     * twice the number of live layouts, so that pruning takes constant amortized time.
+     *
+     */
+    void prune()
+    {
+        for ( auto it = entries_.begin(); it != entries_.end(); )
+        {
+            it = it->second.expired() ? entries_.erase( it ) : std::next( it );
+        }
+        pruneSize_ = std::max< size_t >( MinPruneSize, 2 * entries_.size() );
+    }
+
+    /** Size limits */
+    enum
+    {
+        MinPruneSize = 64, /** Smallest number of entries to prune at */
+        RecentSize = 16 /** Number of the last created layouts kept alive */
+    };
+
+    /** Number of entries to prune at */
+    size_t pruneSize_ = MinPruneSize;
+
+    /** Last created layouts, in a ring buffer */
+    LayoutPtr recent_[RecentSize];
+
+    /** Position of the next created layout in the ring buffer */
+    size_t next_ = 0;
+
+    /** Non-owning references to the layouts by their hash value */
+    std::unordered_multimap< size_t, std::weak_ptr< const ParameterLayout > > entries_;
+};
+
+
+inline LayoutPtr ParameterLayout::create( const ParameterPtrVector& params )
+{
+    if ( params.empty() )
+    {
+        return nullptr;
+    }
+    std::vector< ParameterId > ids( params.size() );
+    for ( size_t i = 0; i < params.size(); i++ )
+    {
+        ids[i] = params[i]->id();
+    }
+    std::sort( ids.begin(), ids.end() );
+    ids.erase( std::unique( ids.begin(), ids.end() ), ids.end() );
+
+    return LayoutRegistry::instance().intern( std::move( ids ), [&]() {
+        ParameterPtrVector sorted = params;
+        std::sort( sorted.begin(), sorted.end(), Less{} );
+        sorted.erase( std::unique( sorted.begin(), sorted.end() ), sorted.end() );
+        return sorted;
+    } );
+}
+
+inline std::vector< const ParameterLayout* > ParameterLayout::distinct(
+    const std::vector< const LayoutPtr* >& layouts )
+{
+    std::vector< const ParameterLayout* > out;
+    out.reserve( layouts.size() );
+    for ( const LayoutPtr* layout : layouts )
+    {
+        if ( *layout )
+        {
+            out.push_back( layout->get() );
+        }
+    }
+    std::sort( out.begin(), out.end() );
+    out.erase( std::unique( out.begin(), out.end() ), out.end() );
+    return out;
+}
+
+inline LayoutPtr ParameterLayout::merge( const std::vector< const LayoutPtr* >& layouts )
+{
+    // Many inputs may share a few layouts, so every distinct layout is merged only once
+    const std::vector< const ParameterLayout* > distinct = ParameterLayout::distinct( layouts );
+
+    const LayoutPtr* largest = nullptr;
+    size_t count = 0;
+    for ( const LayoutPtr* layout : layouts )
+    {
+        if ( *layout && ( !largest || ( *layout )->size() > ( *largest )->size() ) )
+        {
+            largest = layout;
+        }
+    }
+    for ( const ParameterLayout* layout : distinct )
+    {
+        count += layout->size();
+    }
+    if ( !largest || count == ( *largest )->size() )
+    {
+        return largest ? *largest : nullptr;
+    }
+
+    std::vector< ParameterId > ids;
+    ids.reserve( count );
+    for ( const ParameterLayout* layout : distinct )
+    {
+        ids.insert( ids.end(), layout->ids_.begin(), layout->ids_.end() );
+    }
+    std::sort( ids.begin(), ids.end() );
+    ids.erase( std::unique( ids.begin(), ids.end() ), ids.end() );
+    if ( ids.size() == ( *largest )->size() )
+    {
+        return *largest;
+    }
+
+    return LayoutRegistry::instance().intern( std::move( ids ), [&]() {
+        ParameterPtrVector params;
+        params.reserve( count );
+        for ( const ParameterLayout* layout : distinct )
+        {
+            params.insert( params.end(), layout->parameters_.begin(), layout->parameters_.end() );
+        }
+        std::sort( params.begin(), params.end(), Less{} );
+        params.erase( std::unique( params.begin(), params.end() ), params.end() );
+        return params;
+    } );
+}
+
+inline ParameterLayout::Extent ParameterLayout::extent(
+    const std::vector< const LayoutPtr* >& layouts )
+{
+    const std::vector< const ParameterLayout* > distinct = ParameterLayout::distinct( layouts );
+    if ( distinct.size() < 2 )
+    {
+        return distinct.empty() ? Extent{ 0, 0 }
+                                : Extent{ distinct.front()->size(), distinct.front()->dim() };
+    }
+
+    std::vector< std::pair< ParameterId, int > > entries;
+    for ( const ParameterLayout* layout : distinct )
+    {
+        for ( size_t i = 0; i < layout->size(); i++ )
+        {
+            entries.emplace_back( layout->id( i ), layout->dim( i ) );
+        }
+    }
+    std::sort( entries.begin(), entries.end() );
+    Extent out{ 0, 0 };
+    for ( size_t i = 0; i < entries.size(); i++ )
+    {
+        if ( i == 0 || entries[i].first != entries[i - 1].first )
+        {
+            out.size++;
+            out.dim += entries[i].second;
+        }
+    }
+    return out;
+}
+
+inline LayoutPtr ParameterLayout::merge( const LayoutPtr& left, const LayoutPtr& right )
+{
+    if ( !right || left == right )
+    {
+        return left;
+    }
+    if ( !left )
+    {
+        return right;
+    }
+    return merge( std::vector< const LayoutPtr* >{ &left, &right } );
+}
+
+} // namespace metal
+
+#endif // METAL_PARAMETERLAYOUT_H
@@ -0,0 +1,642 @@
+#ifndef METAL_PARTIALVECTOR_H
+#define METAL_PARTIALVECTOR_H
+
+
+#include "src/ScalarBase.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+namespace metal
+{
+
+/**
+ * @brief Storage for partial derivative vectors with small-buffer optimization and a sparse
+ * mode.
+ *
+ * In dense mode vectors up to \ref InlineSize elements are stored inside the object itself,
+ * larger vectors fall back to the heap. The content is exposed through Eigen maps, so arithmetic
+ * is done by Eigen.
+ *
+ * Long vectors with few non-zero elements can be compressed into sparse mode, which stores
+ * sorted index/value pairs only. The values use the same storage as the dense elements, so a few
+ * non-zeros are still stored inline. Eigen maps are only available in dense mode.
+ *
+ */
+class PartialVector
+{
+
+public:
+    /** Alias for Eigen map of the vector */
+    using Map = Eigen::Map< EigenRowVector >;
+
+    /** Alias for Eigen map of the const vector */
+    using ConstMap = Eigen::Map< const EigenRowVector >;
+
+    /** Alias for index/value pair of a sparse element */
+    using Entry = std::pair< int, double >;
+
+    /** Size limits */
+    enum
+    {
+        InlineSize = 8, /** Number of values stored without heap allocation */
+        SparseMinSize = 64, /** Minimum size for which the sparse mode is considered */
+        SparseFillDivisor = 4 /** Sparse mode is used up to a fill of one over this value */
+    };
+
+
+    /**
+     * @brief Construct a new empty Partial Vector object.
+     *
+     */
+    PartialVector()
+        : data_{ inline_ }
+        , index_{ nullptr }
+        , size_{ 0 }
+        , stored_{ 0 }
+        , capacity_{ InlineSize }
+    {
+    }
+
+    /**
+     * @brief Construct a new Partial Vector object by copying an Eigen vector expression.
+     *
+     * @tparam Derived Type of the Eigen expression
+     * @param other Vector expression to copy
+     */
+    template< typename Derived >
+    PartialVector( const Eigen::DenseBase< Derived >& other )
+        : PartialVector{}
+    {
+        resize( static_cast< int >( other.size() ) );
+        map() = other;
+    }
+
+    /**
+     * @brief Copy constructor.
+     *
+     * @param other Vector to copy
+     */
+    PartialVector( const PartialVector& other )
+        : PartialVector{}
+    {
+        assign( other );
+    }
+
+    /**
+     * @brief Move constructor, steals the heap storage of the other vector if there is any.
+     *
+     * @param other Vector to move from
+     */
+    PartialVector( PartialVector&& other ) noexcept
+        : PartialVector{}
+    {
+        *this = std::move( other );
+    }
+
+    /**
+     * @brief Destroy the Partial Vector object.
+     *
+     */
+    ~PartialVector()
+    {
+        release();
+        releaseIndex();
+    }
+
+    /**
+     * @brief Copy assignment, reusing the existing storage if it is large enough.
+     *
+     * @param other Vector to copy
+     * @return PartialVector& Reference to modified object
+     */
+    PartialVector& operator=( const PartialVector& other )
+    {
+        if ( this != &other )
+        {
+            assign( other );
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Move assignment, steals the heap storage of the other vector if there is any. Inline
+     * values are copied into the existing storage, which always has at least the inline capacity,
+     * so moving never allocates.
+     *
+     * @param other Vector to move from
+     * @return PartialVector& Reference to modified object
+     */
+    PartialVector& operator=( PartialVector&& other ) noexcept
+    {
+        if ( this == &other )
+        {
+            return *this;
+        }
+        if ( other.isInline() )
+        {
+            releaseIndex();
+            std::copy( other.data_, other.data_ + other.stored_, data_ );
+            index_ = other.index_;
+            size_ = other.size_;
+            stored_ = other.stored_;
+            other.index_ = nullptr;
+        }
+        else
+        {
+            release();
+            releaseIndex();
+            data_ = other.data_;
+            index_ = other.index_;
+            capacity_ = other.capacity_;
+            size_ = other.size_;
+            stored_ = other.stored_;
+            other.data_ = other.inline_;
+            other.index_ = nullptr;
+            other.capacity_ = InlineSize;
+        }
+        other.size_ = 0;
+        other.stored_ = 0;
+        return *this;
+    }
+
+    /**
+     * @brief Changes the size of the vector and switches to dense mode. The content is undefined
+     * after resizing.
+     *
+     * @param size New size
+     */
+    void resize( int size )
+    {
+        releaseIndex();
+        reserve( size );
+        size_ = size;
+        stored_ = size;
+    }
+
+    /**
+     * @brief Enlarges a vector in dense mode, keeping its elements and setting the new ones to
+     * zero. The storage grows geometrically, so that repeated growth is amortized.
+     *
+     * @param size New size, not smaller than the current one
+     */
+    void grow( int size )
+    {
+        if ( size > capacity_ )
+        {
+            const int capacity = std::max( size, 2 * capacity_ );
+            double* data = new double[static_cast< size_t >( capacity )];
+            std::copy( data_, data_ + size_, data );
+            release();
+            data_ = data;
+            capacity_ = capacity;
+        }
+        std::fill( data_ + size_, data_ + size, 0.0 );
+        size_ = size;
+        stored_ = size;
+    }
+
+    /**
+     * @brief Changes the size of the vector and sets all elements to zero, in dense mode.
+     *
+     * @param size New size
+     */
+    void setZero( int size )
+    {
+        resize( size );
+        std::fill( data_, data_ + size_, 0.0 );
+    }
+
+    /**
+     * @brief Sets the content of the vector from index/value pairs. The pairs are sorted and
+     * entries with the same index are summed. The vector is stored in sparse mode if the number
+     * of non-zeros is small enough, otherwise in dense mode.
+     *
+     * @param size New size
+     * @param entries Index/value pairs, modified by the function
+     */
+    void setSparse( int size, std::vector< Entry >& entries )
+    {
+        std::sort( entries.begin(), entries.end(),
+            []( const Entry& l, const Entry& r ) { return l.first < r.first; } );
+
+        size_t count = 0;
+        for ( size_t i = 0; i < entries.size(); i++ )
+        {
+            if ( count && entries[count - 1].first == entries[i].first )
+            {
+                entries[count - 1].second += entries[i].second;
+            }
+            else
+            {
+                entries[count++] = entries[i];
+            }
+        }
+        entries.resize( count );
+
+        const int nonZeros = static_cast< int >( count );
+        if ( preferSparse( nonZeros, size ) )
+        {
+            releaseIndex();
+            reserve( nonZeros );
+            index_ = new int[count + 1];
+            for ( size_t i = 0; i < count; i++ )
+            {
+                index_[i] = entries[i].first;
+                data_[i] = entries[i].second;
+            }
+            size_ = size;
+            stored_ = nonZeros;
+        }
+        else
+        {
+            setZero( size );
+            for ( const auto& entry : entries )
+            {
+                data_[entry.first] = entry.second;
+            }
+        }
+    }
+
+    /**
+     * @brief Converts the vector into sparse mode if the fill is low enough.
+     *
+     */
+    void compress()
+    {
+        if ( isSparse() || size_ < SparseMinSize )
+        {
+            return;
+        }
+        const int nonZeros
+            = static_cast< int >( size_ - std::count( data_, data_ + size_, 0.0 ) );
+        if ( !preferSparse( nonZeros, size_ ) )
+        {
+            return;
+        }
+
+        int* index = new int[static_cast< size_t >( nonZeros ) + 1];
+        int k = 0;
+        for ( int i = 0; i < size_; i++ )
+        {
+            if ( std::fabs( data_[i] ) <= 0.0 )
+            {
+                continue;
+            }
+            index[k] = i;
+            data_[k++] = data_[i];
+        }
+
+        // Shrink the value storage, possibly into the inline buffer
+        if ( !isInline() && nonZeros <= InlineSize )
+        {
+            std::copy( data_, data_ + nonZeros, inline_ );
+            release();
+        }
+        index_ = index;
+        stored_ = nonZeros;
+    }
+
+    /**
+     * @brief Converts the vector into dense mode.
+     *
+     */
+    void densify()
+    {
+        if ( isSparse() )
+        {
+            PartialVector dense;
+            dense.setZero( size_ );
+            addTo( dense.data(), 0, size_, 1.0 );
+            *this = std::move( dense );
+        }
+    }
+
+    /**
+     * @brief Decides whether the given number of non-zeros should be stored in sparse mode.
+     *
+     * @param nonZeros Number of non-zero elements
+     * @param size Size of the vector
+     * @return true Sparse mode is preferred
+     * @return false Dense mode is preferred
+     */
+    static bool preferSparse( int nonZeros, int size )
+    {
+        return size >= SparseMinSize && SparseFillDivisor * nonZeros <= size;
+    }
+
+    /**
+     * @brief Returns the number of elements.
+     *
+     * @return int Size of the vector
+     */
+    int size() const
+    {
+        return size_;
+    }
+
+    /**
+     * @brief Returns the number of stored elements, equal to the size in dense mode.
+     *
+     * @return int Number of stored elements
+     */
+    int nonZeros() const
+    {
+        return stored_;
+    }
+
+    /**
+     * @brief Checks whether the vector is in sparse mode.
+     *
+     * @return true Only index/value pairs are stored
+     * @return false All elements are stored
+     */
+    bool isSparse() const
+    {
+        return index_ != nullptr;
+    }
+
+    /**
+     * @brief Checks whether the values are stored inside the object.
+     *
+     * @return true No heap storage is used for the values
+     * @return false Values are stored on the heap
+     */
+    bool isInline() const
+    {
+        return data_ == inline_;
+    }
+
+    /**
+     * @brief Returns pointer to the first stored value.
+     *
+     * @return const double* Pointer to the data
+     */
+    const double* data() const
+    {
+        return data_;
+    }
+
+    /**
+     * @brief Returns pointer to the first stored value.
+     *
+     * @return double* Pointer to the data
+     */
+    double* data()
+    {
+        return data_;
+    }
+
+    /**
+     * @brief Returns an Eigen view of the whole vector. Only valid in dense mode.
+     *
+     * @return ConstMap Eigen map
+     */
+    ConstMap map() const
+    {
+        return ConstMap{ data_, size_ };
+    }
+
+    /**
+     * @brief Returns an Eigen view of the whole vector. Only valid in dense mode.
+     *
+     * @return Map Eigen map
+     */
+    Map map()
+    {
+        return Map{ data_, size_ };
+    }
+
+    /**
+     * @brief Returns an Eigen view of a part of the vector. Only valid in dense mode.
+     *
+     * @param start Index of the first element
+     * @param size Number of elements
+     * @return ConstMap Eigen map
+     */
+    ConstMap segment( int start, int size ) const
+    {
+        return ConstMap{ data_ + start, size };
+    }
+
+    /**
+     * @brief Returns an Eigen view of a part of the vector. Only valid in dense mode.
+     *
+     * @param start Index of the first element
+     * @param size Number of elements
+     * @return Map Eigen map
+     */
+    Map segment( int start, int size )
+    {
+        return Map{ data_ + start, size };
+    }
+
+    /**
+     * @brief Returns a dense copy of the vector, in any mode.
+     *
+     * @return EigenRowVector Dense vector
+     */
+    EigenRowVector toDense() const
+    {
+        EigenRowVector out = EigenRowVector::Zero( size_ );
+        addTo( out.data(), 0, size_, 1.0 );
+        return out;
+    }
+
+    /**
+     * @brief Adds a weighted part of the vector to a dense target, in any mode.
+     *
+     * @param target Pointer to the first target element, corresponding to the start
+     * @param start Index of the first element
+     * @param size Number of elements
+     * @param scalar Weight
+     */
+    void addTo( double* target, int start, int size, double scalar ) const
+    {
+        if ( !isSparse() )
+        {
+            Map{ target, size } += scalar * segment( start, size );
+            return;
+        }
+        for ( int k = lowerBound( start ); k < stored_ && index_[k] < start + size; k++ )
+        {
+            target[index_[k] - start] += scalar * data_[k];
+        }
+    }
+
+    /**
+     * @brief Calls a function with the relative index and the value of every stored element in a
+     * part of the vector, in any mode. Zeros of the dense mode are skipped.
+     *
+     * @tparam Func Type of the function
+     * @param start Index of the first element
+     * @param size Number of elements
+     * @param func Function taking the index relative to start and the value
+     */
+    template< typename Func >
+    void visit( int start, int size, Func&& func ) const
+    {
+        if ( !isSparse() )
+        {
+            for ( int i = 0; i < size; i++ )
+            {
+                if ( std::fabs( data_[start + i] ) <= 0.0 )
+                {
+                    continue;
+                }
+                func( i, data_[start + i] );
+            }
+            return;
+        }
+        for ( int k = lowerBound( start ); k < stored_ && index_[k] < start + size; k++ )
+        {
+            func( index_[k] - start, data_[k] );
+        }
+    }
+
+    /**
+     * @brief Adds another vector of the same size multiplied by a scalar to this.
+     *
+     * @param other Vector to add
+     * @param scalar Multiplier
+     */
+    void add( const PartialVector& other, double scalar )
+    {
+        if ( isSparse() && other.isSparse() && stored_ == other.stored_
+            && std::equal( index_, index_ + stored_, other.index_ ) )
+        {
+            Map{ data_, stored_ } += scalar * ConstMap{ other.data_, other.stored_ };
+            return;
+        }
+        if ( isSparse() )
+        {
+            std::vector< Entry > entries;
+            entries.reserve( static_cast< size_t >( stored_ + other.stored_ ) );
+            visit( 0, size_, [&]( int i, double v ) { entries.emplace_back( i, v ); } );
+            other.visit( 0, size_, [&]( int i, double v ) { entries.emplace_back( i, scalar * v ); } );
+            setSparse( size_, entries );
+            return;
+        }
+        other.addTo( data_, 0, size_, scalar );
+    }
+
+    /**
+     * @brief In-place multiplication with a number, in any mode.
+     *
+     * @param scalar Multiplier
+     * @return PartialVector& Reference to modified object
+     */
+    PartialVector& operator*=( double scalar )
+    {
+        Map{ data_, stored_ } *= scalar;
+        return *this;
+    }
+
+    /**
+     * @brief In-place division by a number, in any mode.
+     *
+     * @param scalar Divisor
+     * @return PartialVector& Reference to modified object
+     */
+    PartialVector& operator/=( double scalar )
+    {
+        Map{ data_, stored_ } /= scalar;
+        return *this;
+    }
+
+private:
+    /**
+     * @brief Makes sure that the value storage can hold the given number of values. The content
+     * is undefined afterwards.
+     *
+     * @param capacity Required number of values
+     */
+    void reserve( int capacity )
+    {
+        if ( capacity > capacity_ )
+        {
+            release();
+            data_ = new double[static_cast< size_t >( capacity )];
+            capacity_ = capacity;
+        }
+    }
+
+    /**
+     * @brief Copies the content of another vector, reusing the existing storage if possible.
+     *
+     * @param other Vector to copy
+     */
+    void assign( const PartialVector& other )
+    {
+        resize( other.stored_ );
+        if ( stored_ > 0 )
+        {
+            std::copy( other.data_, other.data_ + stored_, data_ );
+        }
+        if ( other.isSparse() )
+        {
+            index_ = new int[static_cast< size_t >( stored_ ) + 1];
+            std::copy( other.index_, other.index_ + stored_, index_ );
+        }
+        size_ = other.size_;
+    }
+
+    /**
+     * @brief Returns the position of the first stored element with index not less than the given
+     * index, in sparse mode.
+     *
+     * @param index Index to look for
+     * @return int Position in the stored elements
+     */
+    int lowerBound( int index ) const
+    {
+        return static_cast< int >( std::lower_bound( index_, index_ + stored_, index ) - index_ );
+    }
+
+    /**
+     * @brief Releases the heap storage of the values if there is any.
+     *
+     */
+    void release()
+    {
+        if ( !isInline() )
+        {
+            delete[] data_;
+            data_ = inline_;
+            capacity_ = InlineSize;
+        }
+    }
+
+    /**
+     * @brief Releases the index storage of the sparse mode if there is any.
+     *
+     */
+    void releaseIndex()
+    {
+        delete[] index_;
+        index_ = nullptr;
+    }
+
+    /** Pointer to the values, either the inline buffer or heap storage */
+    double* data_;
+
+    /** Sorted indices of the stored values in sparse mode, null pointer in dense mode */
+    int* index_;
+
+    /** Number of elements */
+    int size_;
+
+    /** Number of stored values */
+    int stored_;
+
+    /** Number of values that fit into the current storage */
+    int capacity_;
+
+    /** Inline storage for small vectors */
+    double inline_[InlineSize];
+};
+
+} // metal
+
+#endif // METAL_PARTIALVECTOR_H
@@ -6,21 +6,71 @@
 #include "src/BinaryDivisionOp.h"
 #include "src/BinaryMultiplyOp.h"
 #include "src/BinarySubtractionOp.h"
+#include "src/EvaluationPlan.h"
 #include "src/NamedParameter.h"
+#include "src/NaryAdditionOp.h"
+#include "src/NaryMultiplyOp.h"
+#include "src/ParameterLayout.h"
+#include "src/PartialVector.h"
 #include "src/ScalarBase.h"
 #include "src/ScalarBinaryOp.h"
+#include "src/ScatterSink.h"
 #include "src/UnaryMultiplyOp.h"
+#include <algorithm>
+#include <cmath>
 #include <numeric>
 
 
 namespace metal
 {
 
+/**
+ * @brief Strategy used when a \ref Scalar is constructed from an expression.
+ *
+ */
+enum class Evaluation
+{
+    Scatter, /** Single traversal, every leaf scatters its weighted partials into the result */
+    Accumulate /** Separate traversal of the expression for every parameter */
+};
+
+/**
+ * @brief Type trait for the partial segment type of a scalar. The segment is returned by value,
+ * as the partials may be stored in sparse mode.
+ *
+ */
+template<>
+struct PartialSegment< Scalar >
+{
+    /** Alias for internal type */
+    using Type = EigenRowVector;
+};
+
+/**
+ * @brief A scalar has no parameters if it has no layout, see \ref ParameterFree.
+ *
+ */
+template<>
+struct ParameterFree< Scalar >
+{
+    /**
+     * @brief Checks whether the scalar has no parameters, which is a null layout check.
+     *
+     * @param x Scalar to check
+     * @return true The scalar has no partials
+     * @return false The scalar has parameters
+     */
+    static bool check( const Scalar& x );
+};
+
+
+
 /**
  * @brief Concrete final type of the ET design architecture involving derivatives computation.
  *
  * Represents a scalar quantity including partial derivatives with respect to arbitrary number
- * of external parameters.
+ * of external parameters. Long partial vectors with few non-zeros are stored in sparse mode, see
+ * \ref PartialVector.
  *
  */
 class Scalar : public ScalarBase< Scalar >
@@ -44,7 +94,7 @@ public:
     explicit Scalar( double value = 0.0 )
         : value_{ value }
         , partial_{}
-        , parameterMap_{}
+        , layout_{}
     {
     }
 
@@ -59,8 +109,35 @@ public:
     Scalar( double value, ParameterPtr param, const Partial& partial )
         : value_{ value }
         , partial_{ partial }
-        , parameterMap_{ { param, 0 } }
+        , layout_{ ParameterLayout::create( { param } ) }
     {
+        partial_.compress();
+    }
+
+    /**
+     * @brief Construct a new Scalar object using an existing layout and the given partial vector.
+     *
+     * @throws std::runtime_error
+     *
+     * @param value Value of the scalar object
+     * @param layout Layout of the partial vector, null pointer for no partials
+     * @param partial Partial derivative vector with respect to the layout
+     */
+    Scalar( double value, const LayoutPtr& layout, const Partial& partial )
+        : value_{ value }
+        , partial_{}
+        , layout_{ layout }
+    {
+        if ( static_cast< int >( partial.size() ) != ( layout_ ? layout_->dim() : 0 ) )
+        {
+            throw std::runtime_error( "Error! Partial vector size " + std::to_string( partial.size() )
+                + " does not match the layout dimension" );
+        }
+        if ( layout_ )
+        {
+            partial_ = PartialVector{ partial };
+            partial_.compress();
+        }
     }
 
     /**
@@ -74,7 +151,7 @@ public:
     Scalar( double value, const std::string& name )
         : value_{ value }
         , partial_{ Eigen::Matrix< double, 1, 1 >::Ones() }
-        , parameterMap_{ { { std::make_shared< NamedParameter >( 1, name ), 0 } } }
+        , layout_{ ParameterLayout::create( { std::make_shared< NamedParameter >( 1, name ) } ) }
     {
     }
 
@@ -82,27 +159,116 @@ public:
      * @brief Construct a new Scalar object from an existing expression by forcing the
      * evaluation of the value and partial derivatives.
      *
+     * By default every leaf scatters its weighted partials into the result. The per-parameter
+     * accumulation is kept for comparison.
+     *
+     * If all leaves with partials share the same layout and store dense partials, the result is
+     * the weighted sum of their partial vectors and their layout, so no parameters are merged and
+     * the expression tree is traversed only once. Otherwise the same traversal collects the
+     * layouts of all leaves and counts their stored partials, the layouts are merged once, as the
+     * expression nodes do not merge parameters themselves, and a second traversal scatters the
+     * partials.
+     *
+     * If the partial vector is long and the leaves store few non-zeros in total, the scatter
+     * collects index/value pairs and merges them into a sparse result instead of filling a dense
+     * vector. The result is densified if the merged fill exceeds the threshold of
+     * \ref PartialVector.
+     *
+     * @tparam Expr Type of expression to evaluate
+     * @param expr Expression to evaluate
+     * @param mode Evaluation strategy
+     */
+    template< typename Expr >
+    Scalar( const ScalarBase< Expr >& expr, Evaluation mode = Evaluation::Scatter )
+        : value_{ expr.value() }
+        , partial_{}
+        , layout_{}
+    {
+        detail::LayoutSink layouts;
+        if ( mode == Evaluation::Scatter )
+        {
+            detail::SameLayoutSink same{ partial_, layouts };
+            expr.scatter( same, 1.0 );
+            if ( same.matches() )
+            {
+                layout_ = same.layout();
+                partial_.compress();
+                return;
+            }
+        }
+        else
+        {
+            expr.scatter( layouts, 1.0 );
+        }
+
+        layout_ = layouts.layout();
+        if ( !layout_ )
+        {
+            return;
+        }
+        const int dim = layout_->dim();
+
+        if ( mode == Evaluation::Scatter && dim >= PartialVector::SparseMinSize
+            && PartialVector::preferSparse( layouts.count(), dim ) )
+        {
+            detail::SparseSink sink{ *layout_, layouts.count() };
+            expr.scatter( sink, 1.0 );
+            partial_.setSparse( dim, sink.entries() );
+            return;
+        }
+        partial_.setZero( dim );
+
+        if ( mode == Evaluation::Scatter )
+        {
+            detail::ScatterSink< PartialVector > sink{ partial_, *layout_ };
+            expr.scatter( sink, 1.0 );
+        }
+        else
+        {
+            const auto& params = layout_->parameters();
+            for ( size_t i = 0; i < params.size(); i++ )
+            {
+                auto segment = partial_.segment( layout_->offset( i ), layout_->dim( i ) );
+                expr.accum( segment, params[i] );
+            }
+        }
+        partial_.compress();
+    }
+
+    /**
+     * @brief Construct a new Scalar object from an existing expression, reusing the layout work
+     * recorded in a plan by a previous evaluation at the same call site.
+     *
+     * If the leaves of the expression have the same layouts as when the plan was recorded, the
+     * parameters of the expression are not merged and the result layout is not looked up, only
+     * the partials of the leaves are added. Otherwise the expression is evaluated as usual and
+     * the plan is recorded again.
+     *
      * @tparam Expr Type of expression to evaluate
      * @param expr Expression to evaluate
+     * @param plan Evaluation plan of the call site
      */
     template< typename Expr >
-    Scalar( const ScalarBase< Expr >& expr )
+    Scalar( const ScalarBase< Expr >& expr, EvaluationPlan& plan )
         : value_{ expr.value() }
         , partial_{}
-        , parameterMap_{}
+        , layout_{}
     {
-        const int totalDim = static_cast< int >( expr.dim() );
-        partial_.setZero( totalDim );
+        if ( plan.replay( expr, partial_ ) )
+        {
+            layout_ = plan.layout();
+            partial_.compress();
+            return;
+        }
 
-        int id = 0;
-        const auto& params = expr.parameters();
-        for ( const auto& p : params )
+        layout_ = detail::layoutOf( expr );
+        plan.record( expr, layout_ );
+        partial_.setZero( layout_ ? layout_->dim() : 0 );
+        if ( layout_ )
         {
-            const int dim = p->dim();
-            auto segment = partial_.segment( id, dim );
-            expr.accum( segment, p );
-            parameterMap_[p] = id;
-            id += dim;
+            detail::ScatterSink< PartialVector > sink{ partial_, *layout_ };
+            expr.scatter( sink, 1.0 );
+            partial_.compress();
         }
     }
 
@@ -127,20 +293,16 @@ public:
      */
     size_t size() const
     {
-        return parameterMap_.size();
+        return layout_ ? layout_->size() : 0;
     }
 
     /**
      *  @copydoc ScalarBase::parameters()
      */
-    ParameterPtrVector parameters() const
+    const ParameterPtrVector& parameters() const
     {
-        ParameterPtrVector out;
-        for ( const auto& entry : parameterMap_ )
-        {
-            out.push_back( entry.first );
-        }
-        return out;
+        static const ParameterPtrVector empty{};
+        return layout_ ? layout_->parameters() : empty;
     }
 
     /**
@@ -148,7 +310,7 @@ public:
      */
     bool contains( const ParameterPtr& p ) const
     {
-        return parameterMap_.count( p );
+        return layout_ && layout_->contains( p );
     }
 
     /**
@@ -161,7 +323,9 @@ public:
             throw std::runtime_error( "Error! Parameter not present in partials: '"
                 + ( p ? p->name() : "NULLPTR" ) + "'" );
         }
-        return partial_.segment( parameterMap_.at( p ), p->dim() );
+        PartialSegment out = PartialSegment::Zero( p->dim() );
+        partial_.addTo( out.data(), layout_->offset( p ), p->dim(), 1.0 );
+        return out;
     }
 
     /**
@@ -190,7 +354,7 @@ public:
      */
     void accum( EigenRowVectorSegment& partial, const ParameterPtr& p ) const
     {
-        partial += at( p );
+        accum( partial, 1.0, p );
     }
 
     /**
@@ -198,7 +362,42 @@ public:
      */
     void accum( EigenRowVectorSegment& partial, double scalar, const ParameterPtr& p ) const
     {
-        partial += scalar * at( p );
+        if ( !contains( p ) )
+        {
+            throw std::runtime_error( "Error! Parameter not present in partials: '"
+                + ( p ? p->name() : "NULLPTR" ) + "'" );
+        }
+        partial_.addTo( partial.data(), layout_->offset( p ), p->dim(), scalar );
+    }
+
+    /**
+     *  @copydoc ScalarBase::scatter()
+     */
+    template< typename Sink >
+    void scatter( Sink& sink, double scalar ) const
+    {
+        sink( *this, scalar );
+    }
+
+    /**
+     * @brief Returns the partial derivative vector w.r.t. all the parameters.
+     *
+     * @return const PartialVector& Partial derivative vector, dense or sparse
+     */
+    const PartialVector& partial() const
+    {
+        return partial_;
+    }
+
+    /**
+     * @brief Returns the layout of the partial vector. Scalars with the same parameters share the
+     * same layout object.
+     *
+     * @return const LayoutPtr& Layout of the partial vector, null pointer if there are no partials
+     */
+    const LayoutPtr& layout() const
+    {
+        return layout_;
     }
 
     /**
@@ -251,6 +450,80 @@ public:
         return *this;
     }
 
+    /**
+     * @brief Assigns an expression, evaluating it into the existing partial storage.
+     *
+     * The expression may refer to this scalar, as in `x = x * a + b`. No memory is allocated if
+     * the partial vector has enough capacity, and it grows geometrically if new parameters show
+     * up, so that update loops stop allocating after the first iterations.
+     *
+     * @tparam Expr Type of expression to evaluate
+     * @param expr Expression to evaluate
+     * @return Scalar& Reference to modified object
+     */
+    template< typename Expr >
+    Scalar& operator=( const ScalarBase< Expr >& expr )
+    {
+        assign( expr );
+        return *this;
+    }
+
+    /**
+     * @brief In-place addition operator with an expression.
+     *
+     * @tparam Expr Type of expression to add
+     * @param expr Expression to add to this
+     * @return Scalar& Reference to modified object
+     */
+    template< typename Expr >
+    Scalar& operator+=( const ScalarBase< Expr >& expr )
+    {
+        assign( *this + expr );
+        return *this;
+    }
+
+    /**
+     * @brief In-place subtraction operator with an expression.
+     *
+     * @tparam Expr Type of expression to subtract
+     * @param expr Expression to subtract from this
+     * @return Scalar& Reference to modified object
+     */
+    template< typename Expr >
+    Scalar& operator-=( const ScalarBase< Expr >& expr )
+    {
+        assign( *this - expr );
+        return *this;
+    }
+
+    /**
+     * @brief In-place multiplication operator with an expression.
+     *
+     * @tparam Expr Type of expression to multiply with
+     * @param expr Expression to multiply this with
+     * @return Scalar& Reference to modified object
+     */
+    template< typename Expr >
+    Scalar& operator*=( const ScalarBase< Expr >& expr )
+    {
+        assign( *this * expr );
+        return *this;
+    }
+
+    /**
+     * @brief In-place division operator with an expression.
+     *
+     * @tparam Expr Type of expression to divide with
+     * @param expr Expression to divide this with
+     * @return Scalar& Reference to modified object
+     */
+    template< typename Expr >
+    Scalar& operator/=( const ScalarBase< Expr >& expr )
+    {
+        assign( *this / expr );
+        return *this;
+    }
+
     /**
      * @brief In-place addition operator with another scalar.
      *
@@ -259,18 +532,73 @@ public:
      */
     Scalar& operator+=( const Scalar& other )
     {
-        if ( parameterMap_ == other.parameterMap_ )
+        if ( layout_ == other.layout_ )
         {
             value_ += other.value_;
-            partial_ += other.partial_;
+            partial_.add( other.partial_, 1.0 );
         }
-        else if ( other.size() )
+        else if ( !other.layout_ )
         {
-            *this += other;
+            value_ += other.value_;
+        }
+        else
+        {
+            assign( *this + other );
         }
         return *this;
     }
 
+    /**
+     * @brief In-place subtraction operator with another scalar. A scalar without parameters is
+     * subtracted like a number.
+     *
+     * @param other Scalar object to subtract from this
+     * @return Scalar& Reference to modified object
+     */
+    Scalar& operator-=( const Scalar& other )
+    {
+        if ( !other.layout_ )
+        {
+            return *this -= other.value_;
+        }
+        assign( *this - other );
+        return *this;
+    }
+
+    /**
+     * @brief In-place multiplication operator with another scalar. A scalar without parameters
+     * is multiplied with like a number.
+     *
+     * @param other Scalar object to multiply this with
+     * @return Scalar& Reference to modified object
+     */
+    Scalar& operator*=( const Scalar& other )
+    {
+        if ( !other.layout_ )
+        {
+            return *this *= other.value_;
+        }
+        assign( *this * other );
+        return *this;
+    }
+
+    /**
+     * @brief In-place division operator with another scalar. A scalar without parameters is
+     * divided with like a number.
+     *
+     * @param other Scalar object to divide this with
+     * @return Scalar& Reference to modified object
+     */
+    Scalar& operator/=( const Scalar& other )
+    {
+        if ( !other.layout_ )
+        {
+            return *this /= other.value_;
+        }
+        assign( *this / other );
+        return *this;
+    }
+
     /**
      * @brief Optimised method for adding another scalar object multiplied by a floating point value to this.
      * 
@@ -279,28 +607,115 @@ public:
      */
     void multAndAdd( const Scalar& other, double scalar )
     {
-        if ( parameterMap_ == other.parameterMap_ )
+        if ( layout_ == other.layout_ )
         {
             value_ += scalar * other.value_;
-            partial_ += scalar * other.partial_;
+            partial_.add( other.partial_, scalar );
         }
         else
         {
-            *this += scalar * other;
+            assign( *this + scalar * other );
+        }
+    }
+
+private:
+    /**
+     * @brief Evaluates an expression into this scalar, reusing the partial storage.
+     *
+     * If the expression refers to this scalar, its existing partials are rearranged into the new
+     * layout and scaled by their total weight first, and the other leaves are added afterwards.
+     *
+     * @tparam Expr Type of expression to evaluate
+     * @param expr Expression to evaluate
+     */
+    template< typename Expr >
+    void assign( const ScalarBase< Expr >& expr )
+    {
+        const double value = expr.value();
+        const LayoutPtr layout = detail::layoutOf( expr );
+        detail::LeafWeightSink self{ this };
+        expr.scatter( self, 1.0 );
+
+        if ( !layout )
+        {
+            value_ = value;
+            partial_.setZero( 0 );
+            layout_.reset();
+            return;
+        }
+
+        rebase( layout, self.found() ? self.weight() : 0.0 );
+        detail::ScatterSink< PartialVector > sink{ partial_, *layout };
+        detail::SkipLeafSink< detail::ScatterSink< PartialVector > > others{ sink, this };
+        expr.scatter( others, 1.0 );
+
+        value_ = value;
+        layout_ = layout;
+        partial_.compress();
+    }
+
+    /**
+     * @brief Rearranges the partial vector in dense mode into a layout containing the current
+     * one, and scales it. The segments are moved from the last to the first, so that they are
+     * never overwritten before being moved.
+     *
+     * @param layout New layout, a superset of the current one
+     * @param scalar Multiplier of the existing partials, zero to discard them
+     */
+    void rebase( const LayoutPtr& layout, double scalar )
+    {
+        if ( std::fabs( scalar ) <= 0.0 || !layout_ )
+        {
+            partial_.setZero( layout->dim() );
+            return;
         }
+        partial_.densify();
+
+        if ( layout != layout_ )
+        {
+            const ParameterLayout& from = *layout_;
+            partial_.grow( layout->dim() );
+            double* data = partial_.data();
+            size_t i = from.size();
+            for ( size_t j = layout->size(); j-- > 0; )
+            {
+                const int offset = layout->offset( j );
+                if ( i > 0 && from.id( i - 1 ) == layout->id( j ) )
+                {
+                    --i;
+                    const double* begin = data + from.offset( i );
+                    const int dim = from.dim( i );
+                    std::copy_backward( begin, begin + dim, data + offset + dim );
+                }
+                else
+                {
+                    std::fill( data + offset, data + offset + layout->dim( j ), 0.0 );
+                }
+            }
+        }
+        if ( std::fabs( scalar - 1.0 ) <= 0.0 )
+        {
+            return;
+        }
+        partial_ *= scalar;
     }
 
 private:
     /** Physical value of the scalar */
     double value_;
 
-    /** Storage for partial derivative vector */
-    Partial partial_;
+    /** Storage for partial derivative vector, inline for small dimensions */
+    PartialVector partial_;
 
-    /** Associative map of parameters to their position and dimensino in the partial vector */
-    ParameterMap parameterMap_;
+    /** Shared layout of the partial vector */
+    LayoutPtr layout_;
 };
 
+inline bool ParameterFree< Scalar >::check( const Scalar& x )
+{
+    return !x.layout();
+}
+
 } // metal
 
 #endif // METAL_SCALAR_H
@@ -0,0 +1,234 @@
+#ifndef METAL_SCALARACCUMULATOR_H
+#define METAL_SCALARACCUMULATOR_H
+
+
+#include "src/Scalar.h"
+#include <algorithm>
+#include <vector>
+
+
+namespace metal
+{
+
+class ScalarAccumulator;
+
+
+/**
+ * @brief Type trait for the partial segment type of a scalar accumulator.
+ *
+ */
+template<>
+struct PartialSegment< ScalarAccumulator >
+{
+    /** Alias for internal type */
+    using Type = EigenRowVector;
+};
+
+
+/**
+ * @brief Builder for a weighted sum of any number of scalars, determined at runtime.
+ *
+ * Adding a term only records it and adds its weighted value. The accumulator is an expression,
+ * so constructing a \ref Scalar from it merges the layouts of all terms once, and adds every
+ * weighted term to the result partials in a single pass. If all terms with partials share one
+ * layout, it is used without merging. Summing terms one by one instead creates an intermediate
+ * scalar with its own layout for every addition.
+ *
+ * The terms are referenced, so they have to outlive the accumulator and must not change before
+ * it is evaluated. Expressions and temporary scalars cannot be added, since they would be
+ * released right after the call. Evaluation does not modify the accumulator, so it can be
+ * evaluated from several threads.
+ */
+class ScalarAccumulator : public ScalarBase< ScalarAccumulator >
+{
+
+public:
+    /** Alias for Eigen segment ET to represent part of the derivative vector */
+    using PartialSegment = typename PartialSegment< ScalarAccumulator >::Type;
+
+
+    /**
+     * @brief Construct a new empty Scalar Accumulator object.
+     *
+     * @param capacity Expected number of terms
+     */
+    explicit ScalarAccumulator( size_t capacity = 0 )
+        : terms_{}
+        , value_{ 0.0 }
+    {
+        terms_.reserve( capacity );
+    }
+
+    /**
+     * @brief Adds a weighted term.
+     *
+     * @param term Scalar to add, referenced until evaluation
+     * @param weight Multiplier of the term
+     * @return ScalarAccumulator& Reference to modified object
+     */
+    ScalarAccumulator& add( const Scalar& term, double weight = 1.0 )
+    {
+        terms_.push_back( Term{ &term, weight } );
+        value_ += weight * term.value();
+        return *this;
+    }
+
+    /** Temporary scalars would be referenced after their release */
+    ScalarAccumulator& add( Scalar&&, double = 1.0 ) = delete;
+
+    /** Expressions would be converted to temporary scalars, referenced after their release */
+    template< typename Expr >
+    ScalarAccumulator& add( const ScalarBase< Expr >&, double = 1.0 ) = delete;
+
+    /**
+     * @brief Removes all terms, keeping the allocated memory.
+     *
+     */
+    void clear()
+    {
+        terms_.clear();
+        value_ = 0.0;
+    }
+
+    /**
+     *  @copydoc ScalarBase::value()
+     */
+    double value() const
+    {
+        return value_;
+    }
+
+    /**
+     *  @copydoc ScalarBase::dim()
+     */
+    size_t dim() const
+    {
+        return static_cast< size_t >( detail::extentOf( *this ).dim );
+    }
+
+    /**
+     *  @copydoc ScalarBase::size()
+     */
+    size_t size() const
+    {
+        return detail::extentOf( *this ).size;
+    }
+
+    /**
+     *  @copydoc ScalarBase::parameters()
+     */
+    ParameterPtrVector parameters() const
+    {
+        const LayoutPtr layout = detail::layoutOf( *this );
+        return layout ? layout->parameters() : ParameterPtrVector{};
+    }
+
+    /**
+     *  @copydoc ScalarBase::contains()
+     */
+    bool contains( const ParameterPtr& p ) const
+    {
+        return std::any_of( terms_.begin(), terms_.end(),
+            [&]( const Term& term ) { return term.scalar->contains( p ); } );
+    }
+
+    /**
+     *  @copydoc ScalarBase::at()
+     */
+    PartialSegment at( const ParameterPtr& p ) const
+    {
+        PartialSegment out = PartialSegment::Zero( p->dim() );
+        for ( const auto& term : terms_ )
+        {
+            if ( term.scalar->contains( p ) )
+            {
+                out += term.weight * term.scalar->at( p );
+            }
+        }
+        return out;
+    }
+
+    /**
+     *  @copydoc ScalarBase::accum()
+     */
+    void accum( EigenRowVectorSegment& partial, const ParameterPtr& p ) const
+    {
+        accum( partial, 1.0, p );
+    }
+
+    /**
+     *  @copydoc ScalarBase::accum()
+     */
+    void accum( EigenRowVectorSegment& partial, double scalar, const ParameterPtr& p ) const
+    {
+        for ( const auto& term : terms_ )
+        {
+            if ( term.scalar->contains( p ) )
+            {
+                term.scalar->accum( partial, scalar * term.weight, p );
+            }
+        }
+    }
+
+    /**
+     *  @copydoc ScalarBase::scatter()
+     */
+    template< typename Sink >
+    void scatter( Sink& sink, double scalar ) const
+    {
+        for ( const auto& term : terms_ )
+        {
+            term.scalar->scatter( sink, scalar * term.weight );
+        }
+    }
+
+private:
+    /** Weighted term */
+    struct Term
+    {
+        /** Referenced scalar */
+        const Scalar* scalar;
+
+        /** Multiplier of the scalar */
+        double weight;
+    };
+
+    /** Recorded terms */
+    std::vector< Term > terms_;
+
+    /** Value of the weighted sum */
+    double value_;
+};
+
+
+/**
+ * @brief Computes the weighted sum of scalars, with one union of their parameters and a single
+ * pass over their partials.
+ *
+ * @throws std::runtime_error
+ *
+ * @tparam Weights Type of the weight container, indexable and with a size
+ * @tparam Scalars Type of the scalar container, indexable by reference and with a size
+ * @param weights Multipliers of the scalars
+ * @param scalars Scalars to combine
+ * @return Scalar Weighted sum
+ */
+template< typename Weights, typename Scalars >
+Scalar linearCombination( const Weights& weights, const Scalars& scalars )
+{
+    const size_t size = static_cast< size_t >( scalars.size() );
+    if ( static_cast< size_t >( weights.size() ) != size )
+    {
+        throw std::runtime_error( "Error! Number of weights and scalars do not match" );
+    }
+    ScalarAccumulator accumulator{ size };
+    for ( size_t i = 0; i < size; i++ )
+    {
+        accumulator.add( scalars[i], weights[i] );
+    }
+    return Scalar{ accumulator };
+}
+
+} // metal
+
+#endif // METAL_SCALARACCUMULATOR_H
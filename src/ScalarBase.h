@@ -29,11 +29,16 @@ namespace metal
 /* Alias for eigen row vector */
 using EigenRowVector = Eigen::Matrix< double, 1, -1 >;
 
-/* Alias for eigen row vector segment */
-using EigenRowVectorSegment = Eigen::VectorBlock< EigenRowVector, -1 >;
+/*
+ * Alias for eigen row vector segment. It maps contiguous storage, so that it views the partial
+ * vectors of scalars, which are not Eigen vectors, as well as parts of an Eigen row vector, e.g.
+ * EigenRowVectorSegment{ v.data() + start, size }. It is not a VectorBlock, so segments returned
+ * by Eigen's segment() have to be mapped like this.
+ */
+using EigenRowVectorSegment = Eigen::Map< EigenRowVector >;
 
-/* Alias for eigen row vector const segment */
-using EigenRowVectorConstSegment = Eigen::VectorBlock< const EigenRowVector, -1 >;
+/* Alias for eigen row vector const segment, mapping contiguous storage like the one above */
+using EigenRowVectorConstSegment = Eigen::Map< const EigenRowVector >;
 
 
 /**
@@ -73,6 +78,30 @@ struct RefTypeSelector< Scalar >
     using Type = const Scalar&;
 };
 
+/**
+ * @brief Type trait telling whether an operand of an expression has no parameters at all, without
+ * resolving its parameters. Operations skip such operands when propagating partials, the same way
+ * as number operands.
+ *
+ * The check is only done for leaf types which can answer it cheaply, all other expressions are
+ * assumed to have parameters.
+ *
+ * @tparam Expr Type of the operand expression
+ */
+template< typename Expr >
+struct ParameterFree
+{
+    /**
+     * @brief Checks whether the operand has no parameters.
+     *
+     * @return false Unknown for a general expression
+     */
+    static bool check( const Expr& )
+    {
+        return false;
+    }
+};
+
 /**
  * @brief Base class for the expression template (ET) design pattern of scalar differential
  * algebra system.
@@ -101,7 +130,8 @@ public:
     }
 
     /**
-     * @brief Returns the dimension of the partial derivative vector.
+     * @brief Returns the dimension of the partial derivative vector. Expression nodes merge the
+     * layouts of their leaves for this, see \ref parameters.
      *
      * @return size_t Size of the derivative vector
      */
@@ -124,7 +154,11 @@ public:
     }
 
     /**
-     * @brief Returns the vector of parameters that take part in the partial computation.
+     * @brief Returns the vector of parameters that take part in the partial computation, in
+     * canonical order (increasing identifiers).
+     *
+     * Expression nodes do not store their parameters, they merge the layouts of their leaves on
+     * every call. Evaluating an expression merges them only once, at the root.
      *
      * @return ParameterPtrVector Vector of parameters in partial computation
      *
@@ -189,9 +223,51 @@ public:
     {
         static_cast< const Expr& >( *this ).accum( partial, scalar, p );
     }
+
+    /**
+     * @brief Passes every leaf of the expression to the sink together with the partial of the
+     * expression w.r.t. that leaf, traversing the expression tree only once.
+     *
+     * @tparam Sink Type of the sink receiving the leaf contributions
+     * @param sink Sink receiving the leaf contributions
+     * @param scalar Partial multiplier
+     */
+    template< typename Sink >
+    void scatter( Sink& sink, double scalar ) const
+    {
+        static_cast< const Expr& >( *this ).scatter( sink, scalar );
+    }
 };
 
 
+/**
+ * @brief Returns the value of an expression without evaluating its partial derivatives.
+ *
+ * The values are computed while the expression is built, so this is a plain read which does not
+ * touch the partials or the parameters of the expression.
+ *
+ * @tparam Expr Type of the expression
+ * @param expr Expression to get the value of
+ * @return double Value of the expression
+ */
+template< typename Expr >
+double valueOf( const ScalarBase< Expr >& expr )
+{
+    return expr.value();
+}
+
+/**
+ * @brief Returns the number itself, so that generic code can use \ref valueOf with numbers too.
+ *
+ * @param value Floating point value
+ * @return double The same value
+ */
+inline double valueOf( double value )
+{
+    return value;
+}
+
+
 namespace detail
 {
 
@@ -3,7 +3,7 @@
 
 
 #include "src/ScalarBase.h"
-#include <numeric>
+#include "src/ScatterSink.h"
 
 
 namespace metal
@@ -28,10 +28,96 @@ struct PartialSegment< ScalarBinaryOp< Left, Right, Op > >
 };
 
 
+/**
+ * @brief Value and local partial derivatives of a binary operation, computed together.
+ *
+ */
+struct BinaryResult
+{
+    /** Value of the operation */
+    double value;
+
+    /** Partial derivative w.r.t. the LHS */
+    double left;
+
+    /** Partial derivative w.r.t. the RHS */
+    double right;
+};
+
+
+namespace detail
+{
+
+    /**
+     * @brief Applies a binary operation implementing the fused
+     * `BinaryResult apply( double, double )` method.
+     *
+     * @tparam Op Type of the operation
+     * @param op Operation
+     * @param left Value of the LHS
+     * @param right Value of the RHS
+     * @return BinaryResult Value and partials
+     */
+    template< typename Op >
+    auto applyBinary( const Op& op, double left, double right, int )
+        -> decltype( op.apply( left, right ) )
+    {
+        return op.apply( left, right );
+    }
+
+    /**
+     * @brief Applies a binary operation implementing separate `applyToValue`, `leftPartial` and
+     * `rightPartial` methods.
+     *
+     * @tparam Op Type of the operation
+     * @param op Operation
+     * @param left Value of the LHS
+     * @param right Value of the RHS
+     * @return BinaryResult Value and partials
+     */
+    template< typename Op >
+    BinaryResult applyBinary( const Op& op, double left, double right, long )
+    {
+        return BinaryResult{ op.applyToValue( left, right ), op.leftPartial( left, right ),
+            op.rightPartial( left, right ) };
+    }
+
+    /**
+     * @brief Applies a binary operation, using the fused protocol if the operation implements it.
+     *
+     * @tparam Op Type of the operation
+     * @param op Operation
+     * @param left Value of the LHS
+     * @param right Value of the RHS
+     * @return BinaryResult Value and partials
+     */
+    template< typename Op >
+    BinaryResult applyBinary( const Op& op, double left, double right )
+    {
+        return applyBinary( op, left, right, 0 );
+    }
+
+} // detail
+
+
 /**
  * @brief Proxy ET type to represent a binary operation which uses two other sub-expressions as
  * left-hand-side (LHS) and right-hand-side (RHS).
  *
+ * The value and the partials w.r.t. both sides are computed once at construction. Operations
+ * preferably implement `BinaryResult apply( double left, double right ) const`, returning them
+ * together, otherwise `applyToValue`, `leftPartial` and `rightPartial` are called separately.
+ *
+ * Operands known to have no parameters, see \ref ParameterFree, are skipped when propagating
+ * partials, so that a constant scalar costs the same as a number operand. Their partials are
+ * stored as zero, which also discards partials outside the domain of the operation, such as the
+ * exponent partial of a negative base.
+ *
+ * The node does not merge the parameters of its operands. Building an expression and reading its
+ * value, see \ref valueOf, therefore does no parameter bookkeeping at all, and evaluating it into
+ * a \ref Scalar merges the layouts of all leaves once, at the root. Querying the dimension or size
+ * of a node merges only the identifiers of the leaf layouts, without creating a layout.
+ *
  * @tparam Left Left hand side expression type in the binary operation
  * @tparam Right Right hand side expression type in the binary operation
  * @tparam Op Binary operation type
@@ -57,44 +143,8 @@ public:
      * @param op Operation to apply on LHS and RHS
      */
     ScalarBinaryOp( const Left& left, const Right& right, const Op& op )
-        : left_( left )
-        , right_( right )
-        , op_( op )
-        , cache_{ left_.value(), right_.value() }
-        , value_{ op_.applyToValue( cache_.first, cache_.second ) }
-        , parameters_{}
-        , totalDim_{ 0 }
+        : ScalarBinaryOp{ left, right, detail::applyBinary( op, left.value(), right.value() ) }
     {
-        if ( left_.size() && right_.size() )
-        {
-            if ( left_.parameters() == right_.parameters() )
-            {
-                parameters_ = left_.parameters();
-            }
-            else
-            {
-                parameters_ = left_.parameters();
-                for ( const auto& p : right_.parameters() )
-                {
-                    if ( std::find( parameters_.begin(), parameters_.end(), p ) == parameters_.end() )
-                    // if ( !std::binary_search( parameters_.begin(), parameters_.end(), p ) )
-                    {
-                        parameters_.push_back( p );
-                    }
-                }
-            }
-        }
-        else if ( left_.size() == 0 && right_.size() == 0 )
-        {
-        }
-        else if ( left_.size() )
-        {
-            parameters_ = left_.parameters();
-        }
-        else // right_.size()
-        {
-            parameters_ = right_.parameters();
-        }
     }
 
     /**
@@ -105,15 +155,13 @@ public:
         return value_;
     }
 
+
     /**
      *  @copydoc ScalarBase::dim()
      */
     size_t dim() const
     {
-        // @TODO: This could be cached, but is only ever called once in Scalar constructor, and I
-        // don't see other application from the user point of view
-        const auto func = []( int tmp, const ParameterPtr& p ) { return tmp + p->dim(); };
-        return std::accumulate( parameters_.begin(), parameters_.end(), size_t{ 0 }, func );
+        return static_cast< size_t >( detail::extentOf( *this ).dim );
     }
 
     /**
@@ -121,15 +169,16 @@ public:
      */
     size_t size() const
     {
-        return parameters_.size();
+        return detail::extentOf( *this ).size;
     }
 
     /**
      *  @copydoc ScalarBase::parameters()
      */
-    const ParameterPtrVector& parameters() const
+    ParameterPtrVector parameters() const
     {
-        return parameters_;
+        const LayoutPtr layout = detail::layoutOf( *this );
+        return layout ? layout->parameters() : ParameterPtrVector{};
     }
 
     /**
@@ -137,9 +186,8 @@ public:
      */
     bool contains( const ParameterPtr& p ) const
     {
-        // @TODO: Since the parameter vector is sorted, this should be O(N). Maybe it should be
-        // replaced by std::set to have O(1) complexity
-        return std::find( parameters_.begin(), parameters_.end(), p ) != parameters_.end();
+        return ( !constantLeft_ && left_.contains( p ) )
+            || ( !constantRight_ && right_.contains( p ) );
     }
 
     /**
@@ -153,13 +201,13 @@ public:
 
         PartialSegment out = PartialSegment::Zero( p->dim() );
 
-        if ( left_.contains( p ) )
+        if ( !constantLeft_ && left_.contains( p ) )
         {
-            out += op_.leftPartial( cache_.first, cache_.second ) * left_.at( p );
+            out += leftPartial_ * left_.at( p );
         }
-        if ( right_.contains( p ) )
+        if ( !constantRight_ && right_.contains( p ) )
         {
-            out += op_.rightPartial( cache_.first, cache_.second ) * right_.at( p );
+            out += rightPartial_ * right_.at( p );
         }
 
         return out;
@@ -170,13 +218,13 @@ public:
      */
     void accum( EigenRowVectorSegment& partial, const ParameterPtr& p ) const
     {
-        if ( left_.contains( p ) )
+        if ( !constantLeft_ && left_.contains( p ) )
         {
-            left_.accum( partial, op_.leftPartial( cache_.first, cache_.second ), p );
+            left_.accum( partial, leftPartial_, p );
         }
-        if ( right_.contains( p ) )
+        if ( !constantRight_ && right_.contains( p ) )
         {
-            right_.accum( partial, op_.rightPartial( cache_.first, cache_.second ), p );
+            right_.accum( partial, rightPartial_, p );
         }
     }
 
@@ -185,19 +233,91 @@ public:
      */
     void accum( EigenRowVectorSegment& partial, double scalar, const ParameterPtr& p ) const
     {
-        if ( left_.contains( p ) )
+        if ( !constantLeft_ && left_.contains( p ) )
         {
-            left_.accum( partial, scalar * op_.leftPartial( cache_.first, cache_.second ), p );
+            left_.accum( partial, scalar * leftPartial_, p );
         }
-        if ( right_.contains( p ) )
+        if ( !constantRight_ && right_.contains( p ) )
         {
-            right_.accum( partial, scalar * op_.rightPartial( cache_.first, cache_.second ), p );
+            right_.accum( partial, scalar * rightPartial_, p );
         }
     }
 
+    /**
+     *  @copydoc ScalarBase::scatter()
+     */
+    template< typename Sink >
+    void scatter( Sink& sink, double scalar ) const
+    {
+        if ( !constantLeft_ )
+        {
+            left_.scatter( sink, scalar * leftPartial_ );
+        }
+        if ( !constantRight_ )
+        {
+            right_.scatter( sink, scalar * rightPartial_ );
+        }
+    }
+
+    /**
+     * @brief Returns the LHS expression.
+     *
+     * @return const Left& LHS expression
+     */
+    const Left& left() const
+    {
+        return left_;
+    }
+
+    /**
+     * @brief Returns the RHS expression.
+     *
+     * @return const Right& RHS expression
+     */
+    const Right& right() const
+    {
+        return right_;
+    }
+
+    /**
+     * @brief Returns the partial of the operation w.r.t. the LHS.
+     *
+     * @return double Partial w.r.t. the LHS
+     */
+    double leftPartial() const
+    {
+        return leftPartial_;
+    }
+
+    /**
+     * @brief Returns the partial of the operation w.r.t. the RHS.
+     *
+     * @return double Partial w.r.t. the RHS
+     */
+    double rightPartial() const
+    {
+        return rightPartial_;
+    }
+
 private:
-    /** Alias for cache of the operator partials */
-    using Cache = std::pair< double, double >;
+    /**
+     * @brief Construct a new Scalar Binary Op object from the already computed value and
+     * partials.
+     *
+     * @param left Left-hand-side expression
+     * @param right Right-hand-side expression
+     * @param result Value and partials of the operation
+     */
+    ScalarBinaryOp( const Left& left, const Right& right, const BinaryResult& result )
+        : left_( left )
+        , right_( right )
+        , value_{ result.value }
+        , constantLeft_{ ParameterFree< Left >::check( left ) }
+        , constantRight_{ ParameterFree< Right >::check( right ) }
+        , leftPartial_{ constantLeft_ ? 0.0 : result.left }
+        , rightPartial_{ constantRight_ ? 0.0 : result.right }
+    {
+    }
 
     /** LHS expression */
     typename RefTypeSelector< Left >::Type left_;
@@ -205,19 +325,20 @@ private:
     /** RHS expression */
     typename RefTypeSelector< Right >::Type right_;
 
-    /** Binary operator */
-    Op op_;
+    /** Computed expression value */
+    double value_;
 
-    /** Cached operator partials */
-    Cache cache_;
+    /** Whether the LHS is known to have no parameters */
+    bool constantLeft_;
 
-    /** Cached value */
-    double value_;
+    /** Whether the RHS is known to have no parameters */
+    bool constantRight_;
 
-    /** Cached parameters from expression */
-    ParameterPtrVector parameters_;
+    /** Partial w.r.t. the LHS, zero for an LHS without parameters */
+    double leftPartial_;
 
-    int totalDim_;
+    /** Partial w.r.t. the RHS, zero for an RHS without parameters */
+    double rightPartial_;
 };
 
 } // metal
@@ -0,0 +1,357 @@
+#ifndef METAL_SCALARN_H
+#define METAL_SCALARN_H
+
+
+#include "src/BinaryAdditionOp.h"
+#include "src/NamedParameter.h"
+#include "src/NaryAdditionOp.h"
+#include "src/ParameterLayout.h"
+#include "src/ScalarBase.h"
+#include "src/ScatterSink.h"
+#include "src/UnaryMultiplyOp.h"
+
+
+namespace metal
+{
+
+template< int N >
+class ScalarN;
+
+
+/**
+ * @brief Type trait for the partial type of a fixed dimension scalar.
+ *
+ * Alignment is disabled, so that the scalar can be stored in standard containers and passed by
+ * value without alignment requirements.
+ *
+ * @tparam N Dimension of the partial derivative vector
+ */
+template< int N >
+struct Partial< ScalarN< N > >
+{
+    /** Alias for internal type */
+    using Type = Eigen::Matrix< double, 1, N, Eigen::RowMajor | Eigen::DontAlign >;
+};
+
+
+/**
+ * @brief Concrete final type of the ET design architecture with partial derivative vector of
+ * compile-time dimension.
+ *
+ * The parameter layout is fixed at construction, and its dimension has to be equal to N. As the
+ * partials are stored in a fixed size Eigen vector, partial arithmetic between scalars of the
+ * same layout is unrolled and vectorized by the compiler without heap allocation. A scalar
+ * without parameters has no layout, and its partials are zero.
+ *
+ * @tparam N Dimension of the partial derivative vector
+ */
+template< int N >
+class ScalarN : public ScalarBase< ScalarN< N > >
+{
+
+public:
+    /** Alias for type of partial derivative vector. Using fixed size Eigen row vector */
+    using Partial = typename Partial< ScalarN< N > >::Type;
+
+    /** Alias for Eigen segment ET to represent part of the derivative vector */
+    using PartialSegment = typename PartialSegment< ScalarN< N > >::Type;
+
+
+    /**
+     * @brief Construct a new ScalarN object without holding partial deriatives.
+     *
+     * Default for the value is zero.
+     *
+     * @param value Value of the scalar object
+     */
+    explicit ScalarN( double value = 0.0 )
+        : value_{ value }
+        , partial_{ Partial::Zero() }
+        , layout_{}
+    {
+    }
+
+    /**
+     * @brief Construct a new ScalarN object using a specific parameter object and the given
+     * partial vector w.r.t. that parameter.
+     *
+     * @throws std::runtime_error
+     *
+     * @param value Value of the scalar object
+     * @param param Parameter of dimension N
+     * @param partial Partial derivative vector with respect to the parameter
+     */
+    ScalarN( double value, ParameterPtr param, const Partial& partial )
+        : ScalarN{ value, ParameterLayout::create( { param } ), partial }
+    {
+    }
+
+    /**
+     * @brief Construct a new ScalarN object using an existing layout and the given partial
+     * vector.
+     *
+     * @throws std::runtime_error
+     *
+     * @param value Value of the scalar object
+     * @param layout Layout of dimension N
+     * @param partial Partial derivative vector with respect to the layout
+     */
+    ScalarN( double value, const LayoutPtr& layout, const Partial& partial )
+        : value_{ value }
+        , partial_{ partial }
+        , layout_{ layout }
+    {
+        check();
+    }
+
+    /**
+     * @brief Construct a new ScalarN object and creates a parameter with the specified name. Only
+     * available for unit dimension.
+     *
+     * The partial derivative w.r.t. this parameter is initialized to unity.
+     *
+     * @param value Value of the scalar
+     * @param name Name of the parameter
+     */
+    ScalarN( double value, const std::string& name )
+        : ScalarN{ value, std::make_shared< NamedParameter >( 1, name ), Partial::Ones() }
+    {
+        static_assert( N == 1, "Named parameter constructor requires unit dimension" );
+    }
+
+    /**
+     * @brief Construct a new ScalarN object from an existing expression by forcing the
+     * evaluation of the value and partial derivatives.
+     *
+     * If all leaves with partials share the same layout, which is the common case for the
+     * elements of a state vector, their weighted partials are added to the fixed size vector in
+     * a single traversal, without heap allocation and without looking up a layout. Otherwise the
+     * layouts collected in that traversal are merged, and the partials are scattered in a second
+     * one.
+     *
+     * @throws std::runtime_error
+     *
+     * @tparam Expr Type of expression to evaluate
+     * @param expr Expression to evaluate, with partials of dimension N or without partials
+     */
+    template< typename Expr >
+    ScalarN( const ScalarBase< Expr >& expr )
+        : value_{ expr.value() }
+        , partial_{ Partial::Zero() }
+        , layout_{}
+    {
+        detail::LayoutSink layouts;
+        detail::FixedLayoutSink< Partial > same{ partial_, layouts };
+        expr.scatter( same, 1.0 );
+        if ( same.matches() )
+        {
+            layout_ = same.layout();
+            return;
+        }
+
+        layout_ = layouts.layout();
+        check();
+        partial_.setZero();
+        detail::ScatterSink< Partial > sink{ partial_, *layout_ };
+        expr.scatter( sink, 1.0 );
+    }
+
+    /**
+     *  @copydoc ScalarBase::value()
+     */
+    double value() const
+    {
+        return value_;
+    }
+
+    /**
+     *  @copydoc ScalarBase::dim()
+     */
+    size_t dim() const
+    {
+        return layout_ ? N : 0;
+    }
+
+    /**
+     *  @copydoc ScalarBase::size()
+     */
+    size_t size() const
+    {
+        return layout_ ? layout_->size() : 0;
+    }
+
+    /**
+     *  @copydoc ScalarBase::parameters()
+     */
+    const ParameterPtrVector& parameters() const
+    {
+        static const ParameterPtrVector empty{};
+        return layout_ ? layout_->parameters() : empty;
+    }
+
+    /**
+     *  @copydoc ScalarBase::contains()
+     */
+    bool contains( const ParameterPtr& p ) const
+    {
+        return layout_ && layout_->contains( p );
+    }
+
+    /**
+     *  @copydoc ScalarBase::at()
+     */
+    PartialSegment at( const ParameterPtr& p ) const
+    {
+        if ( !contains( p ) )
+        {
+            throw std::runtime_error( "Error! Parameter not present in partials: '"
+                + ( p ? p->name() : "NULLPTR" ) + "'" );
+        }
+        return PartialSegment{ partial_.data() + layout_->offset( p ), p->dim() };
+    }
+
+    /**
+     *  @copydoc ScalarBase::accum()
+     */
+    void accum( EigenRowVectorSegment& partial, const ParameterPtr& p ) const
+    {
+        partial += at( p );
+    }
+
+    /**
+     *  @copydoc ScalarBase::accum()
+     */
+    void accum( EigenRowVectorSegment& partial, double scalar, const ParameterPtr& p ) const
+    {
+        partial += scalar * at( p );
+    }
+
+    /**
+     *  @copydoc ScalarBase::scatter()
+     */
+    template< typename Sink >
+    void scatter( Sink& sink, double scalar ) const
+    {
+        sink( *this, scalar );
+    }
+
+    /**
+     * @brief Returns the partial derivative vector w.r.t. all the parameters.
+     *
+     * @return const Partial& Partial derivative vector
+     */
+    const Partial& partial() const
+    {
+        return partial_;
+    }
+
+    /**
+     * @brief Returns the layout of the partial vector.
+     *
+     * @return const LayoutPtr& Layout of the partial vector, null pointer if there are no partials
+     */
+    const LayoutPtr& layout() const
+    {
+        return layout_;
+    }
+
+    /**
+     * @brief In-place addition operator with a number.
+     *
+     * @param other Floating point value to add
+     * @return ScalarN& Reference to modified object
+     */
+    ScalarN& operator+=( double other )
+    {
+        value_ += other;
+        return *this;
+    }
+
+    /**
+     * @brief In-place subtraction operator with a number.
+     *
+     * @param other Floating point value to subtract
+     * @return ScalarN& Reference to modified object
+     */
+    ScalarN& operator-=( double other )
+    {
+        value_ -= other;
+        return *this;
+    }
+
+    /**
+     * @brief In-place multiplication operator with a number.
+     *
+     * @param other Floating point value to multiply with
+     * @return ScalarN& Reference to modified object
+     */
+    ScalarN& operator*=( double other )
+    {
+        value_ *= other;
+        partial_ *= other;
+        return *this;
+    }
+
+    /**
+     * @brief In-place division operator with a number.
+     *
+     * @param other Floating point value to divide with
+     * @return ScalarN& Reference to modified object
+     */
+    ScalarN& operator/=( double other )
+    {
+        value_ /= other;
+        partial_ /= other;
+        return *this;
+    }
+
+    /**
+     * @brief Optimised method for adding another scalar object multiplied by a floating point
+     * value to this.
+     *
+     * @throws std::runtime_error
+     *
+     * @param other Scalar object to add to this
+     * @param scalar Multiplier
+     */
+    void multAndAdd( const ScalarN& other, double scalar )
+    {
+        if ( layout_ == other.layout_ || !other.layout_ )
+        {
+            value_ += scalar * other.value_;
+            partial_ += scalar * other.partial_;
+        }
+        else
+        {
+            *this = ScalarN{ *this + scalar * other };
+        }
+    }
+
+private:
+    /**
+     * @brief Checks that the layout has the dimension of the partial vector.
+     *
+     * @throws std::runtime_error
+     */
+    void check() const
+    {
+        if ( layout_ && layout_->dim() != N )
+        {
+            throw std::runtime_error( "Error! Layout dimension " + std::to_string( layout_->dim() )
+                + " does not match the fixed dimension " + std::to_string( N ) );
+        }
+    }
+
+    /** Physical value of the scalar */
+    double value_;
+
+    /** Storage for partial derivative vector */
+    Partial partial_;
+
+    /** Shared layout of the partial vector */
+    LayoutPtr layout_;
+};
+
+} // metal
+
+#endif // METAL_SCALARN_H
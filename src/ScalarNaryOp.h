@@ -0,0 +1,428 @@
+#ifndef METAL_SCALARNARYOP_H
+#define METAL_SCALARNARYOP_H
+
+
+#include "src/ScalarBase.h"
+#include "src/ScalarBinaryOp.h"
+#include "src/ScatterSink.h"
+#include <array>
+#include <tuple>
+
+
+namespace metal
+{
+
+template< typename Op, typename... Exprs >
+class ScalarNaryOp;
+
+
+/**
+ * @brief Type trait for the partial segment type of a scalar n-ary operator.
+ *
+ * @tparam Op N-ary operation type
+ * @tparam Exprs Operand expression types
+ */
+template< typename Op, typename... Exprs >
+struct PartialSegment< ScalarNaryOp< Op, Exprs... > >
+{
+    /** Alias for internal type */
+    using Type = EigenRowVector;
+};
+
+
+namespace detail
+{
+
+    /**
+     * @brief Calls a function with every element of a tuple of operands and its index, unrolled
+     * at compile time.
+     *
+     * @tparam I Index of the current operand
+     * @tparam N Number of operands
+     */
+    template< size_t I, size_t N >
+    struct ForEachOperand
+    {
+        /**
+         * @brief Calls the function with the operands from index I on.
+         *
+         * @tparam Tuple Type of the tuple of operands
+         * @tparam Func Type of the function
+         * @param operands Tuple of operands
+         * @param func Function taking an operand and its index
+         */
+        template< typename Tuple, typename Func >
+        static void apply( const Tuple& operands, Func& func )
+        {
+            func( std::get< I >( operands ), I );
+            ForEachOperand< I + 1, N >::apply( operands, func );
+        }
+    };
+
+    /**
+     * @brief End of the compile-time loop over the operands.
+     *
+     * @tparam N Number of operands
+     */
+    template< size_t N >
+    struct ForEachOperand< N, N >
+    {
+        template< typename Tuple, typename Func >
+        static void apply( const Tuple&, Func& )
+        {
+        }
+    };
+
+} // detail
+
+
+/**
+ * @brief Proxy ET type to represent an associative operation on any number of sub-expressions,
+ * created by flattening chains of binary operations such as `a + b - c + d` or `a * b * c`.
+ *
+ * A chain of binary operations is a left-deep tree with a recursive call per level. This node
+ * instead references all operands directly, and scatters or accumulates every operand with its
+ * local partial in one unrolled loop. Like every node, it does not merge the parameters of its
+ * operands, the evaluation root merges the layouts of all leaves once.
+ *
+ * The operation type defines how the node is extended by one more operand through
+ * `double combine( double value, double operand, double weight )`, which returns the new value,
+ * `double scale( double operand )`, which is the factor applied to the partials w.r.t. the
+ * existing operands, and `double partial( double value, double weight )`, which is the partial
+ * w.r.t. the new operand.
+ *
+ * A chain of operators creates a new node per operand, each one copying the operands of the
+ * previous node. The node of a long chain is best built at once from all its operands, e.g. by
+ * \ref sum or \ref product.
+ *
+ * Operands known to have no parameters, see \ref ParameterFree, are skipped when propagating
+ * partials.
+ *
+ * @tparam Op N-ary operation type
+ * @tparam Exprs Operand expression types
+ */
+template< typename Op, typename... Exprs >
+class ScalarNaryOp : public ScalarBase< ScalarNaryOp< Op, Exprs... > >
+{
+
+public:
+    /** Alias for type of partial derivative vector. */
+    using Partial = EigenRowVector;
+
+    /** Alias for Eigen segment ET to represent part of the derivative vector */
+    using PartialSegment = typename PartialSegment< ScalarNaryOp< Op, Exprs... > >::Type;
+
+    /** Alias for the tuple of references to the operands */
+    using Operands = std::tuple< typename RefTypeSelector< Exprs >::Type... >;
+
+    /** Alias for the local partials w.r.t. the operands */
+    using Partials = std::array< double, sizeof...( Exprs ) >;
+
+    /** Alias for the flags of the operands known to have no parameters */
+    using Constants = std::array< bool, sizeof...( Exprs ) >;
+
+
+    /**
+     * @brief Construct a new Scalar Nary Op object from its operands, value and local partials.
+     *
+     * @param operands References to the operands
+     * @param value Value of the operation
+     * @param partials Partials of the operation w.r.t. the operands
+     */
+    ScalarNaryOp( const Operands& operands, double value, const Partials& partials )
+        : operands_( operands )
+        , value_{ value }
+        , partials_( partials )
+        , constants_{}
+    {
+        Classify func{ constants_ };
+        detail::ForEachOperand< 0, sizeof...( Exprs ) >::apply( operands_, func );
+    }
+
+    /**
+     * @brief Construct a new Scalar Nary Op object from all its operands at once, each with unit
+     * weight.
+     *
+     * The value is combined from the first operand on. The partial w.r.t. every operand is then
+     * scaled by the factors of all later operands, which are multiplied from the last operand
+     * backwards, so the node is built in linear time.
+     *
+     * @param exprs Operands
+     */
+    explicit ScalarNaryOp( const Exprs&... exprs )
+        : operands_( exprs... )
+        , value_{ 0.0 }
+        , partials_{}
+        , constants_{}
+    {
+        const Partials values{ { exprs.value()... } };
+        value_ = values[0];
+        partials_[0] = 1.0;
+        for ( size_t i = 1; i < values.size(); i++ )
+        {
+            partials_[i] = Op::partial( value_, 1.0 );
+            value_ = Op::combine( value_, values[i], 1.0 );
+        }
+        double scale = 1.0;
+        for ( size_t i = values.size(); i-- > 0; )
+        {
+            partials_[i] *= scale;
+            scale *= Op::scale( values[i] );
+        }
+
+        Classify func{ constants_ };
+        detail::ForEachOperand< 0, sizeof...( Exprs ) >::apply( operands_, func );
+    }
+
+    /**
+     * @brief Creates a new operation with one more operand.
+     *
+     * @tparam Expr Type of the new operand
+     * @param expr New operand
+     * @param weight Weight of the new operand, passed to the operation
+     * @return ScalarNaryOp< Op, Exprs..., Expr > Extended operation
+     */
+    template< typename Expr >
+    ScalarNaryOp< Op, Exprs..., Expr > append( const Expr& expr, double weight ) const
+    {
+        using Extended = ScalarNaryOp< Op, Exprs..., Expr >;
+        typename Extended::Partials partials;
+        typename Extended::Constants constants;
+        const double scale = Op::scale( expr.value() );
+        for ( size_t i = 0; i < partials_.size(); i++ )
+        {
+            partials[i] = scale * partials_[i];
+            constants[i] = constants_[i];
+        }
+        partials.back() = Op::partial( value_, weight );
+        constants.back() = ParameterFree< Expr >::check( expr );
+
+        return Extended{ std::tuple_cat( operands_, std::forward_as_tuple( expr ) ),
+            Op::combine( value_, expr.value(), weight ), partials, constants };
+    }
+
+    /**
+     *  @copydoc ScalarBase::value()
+     */
+    double value() const
+    {
+        return value_;
+    }
+
+    /**
+     *  @copydoc ScalarBase::dim()
+     */
+    size_t dim() const
+    {
+        return static_cast< size_t >( detail::extentOf( *this ).dim );
+    }
+
+    /**
+     *  @copydoc ScalarBase::size()
+     */
+    size_t size() const
+    {
+        return detail::extentOf( *this ).size;
+    }
+
+    /**
+     *  @copydoc ScalarBase::parameters()
+     */
+    ParameterPtrVector parameters() const
+    {
+        const LayoutPtr layout = detail::layoutOf( *this );
+        return layout ? layout->parameters() : ParameterPtrVector{};
+    }
+
+    /**
+     *  @copydoc ScalarBase::contains()
+     */
+    bool contains( const ParameterPtr& p ) const
+    {
+        Contains func{ constants_, p, false };
+        detail::ForEachOperand< 0, sizeof...( Exprs ) >::apply( operands_, func );
+        return func.found;
+    }
+
+    /**
+     *  @copydoc ScalarBase::at()
+     */
+    PartialSegment at( const ParameterPtr& p ) const
+    {
+        PartialSegment out = PartialSegment::Zero( p->dim() );
+        At func{ out, partials_, constants_, p };
+        detail::ForEachOperand< 0, sizeof...( Exprs ) >::apply( operands_, func );
+        return out;
+    }
+
+    /**
+     *  @copydoc ScalarBase::accum()
+     */
+    void accum( EigenRowVectorSegment& partial, const ParameterPtr& p ) const
+    {
+        accum( partial, 1.0, p );
+    }
+
+    /**
+     *  @copydoc ScalarBase::accum()
+     */
+    void accum( EigenRowVectorSegment& partial, double scalar, const ParameterPtr& p ) const
+    {
+        Accum func{ partial, partials_, constants_, scalar, p };
+        detail::ForEachOperand< 0, sizeof...( Exprs ) >::apply( operands_, func );
+    }
+
+    /**
+     *  @copydoc ScalarBase::scatter()
+     */
+    template< typename Sink >
+    void scatter( Sink& sink, double scalar ) const
+    {
+        Scatter< Sink > func{ sink, partials_, constants_, scalar };
+        detail::ForEachOperand< 0, sizeof...( Exprs ) >::apply( operands_, func );
+    }
+
+private:
+    template< typename, typename... >
+    friend class ScalarNaryOp;
+
+    /**
+     * @brief Construct a new Scalar Nary Op object from its operands, value, local partials and
+     * the operands already known to have no parameters.
+     *
+     * @param operands References to the operands
+     * @param value Value of the operation
+     * @param partials Partials of the operation w.r.t. the operands
+     * @param constants Operands known to have no parameters
+     */
+    ScalarNaryOp( const Operands& operands, double value, const Partials& partials,
+        const Constants& constants )
+        : operands_( operands )
+        , value_{ value }
+        , partials_( partials )
+        , constants_( constants )
+    {
+    }
+
+    /** Determines the operands known to have no parameters */
+    struct Classify
+    {
+        template< typename Expr >
+        void operator()( const Expr& expr, size_t i )
+        {
+            constants[i] = ParameterFree< Expr >::check( expr );
+        }
+
+        Constants& constants;
+    };
+
+    /** Checks whether any operand contains a parameter */
+    struct Contains
+    {
+        template< typename Expr >
+        void operator()( const Expr& expr, size_t i )
+        {
+            found = found || ( !constants[i] && expr.contains( p ) );
+        }
+
+        const Constants& constants;
+        const ParameterPtr& p;
+        bool found;
+    };
+
+    /** Adds the weighted partials of every operand containing a parameter */
+    struct At
+    {
+        template< typename Expr >
+        void operator()( const Expr& expr, size_t i )
+        {
+            if ( !constants[i] && expr.contains( p ) )
+            {
+                out += partials[i] * expr.at( p );
+            }
+        }
+
+        PartialSegment& out;
+        const Partials& partials;
+        const Constants& constants;
+        const ParameterPtr& p;
+    };
+
+    /** Accumulates the weighted partials of every operand containing a parameter */
+    struct Accum
+    {
+        template< typename Expr >
+        void operator()( const Expr& expr, size_t i )
+        {
+            if ( !constants[i] && expr.contains( p ) )
+            {
+                expr.accum( partial, scalar * partials[i], p );
+            }
+        }
+
+        EigenRowVectorSegment& partial;
+        const Partials& partials;
+        const Constants& constants;
+        double scalar;
+        const ParameterPtr& p;
+    };
+
+    /** Scatters every operand with its weight */
+    template< typename Sink >
+    struct Scatter
+    {
+        template< typename Expr >
+        void operator()( const Expr& expr, size_t i )
+        {
+            if ( !constants[i] )
+            {
+                expr.scatter( sink, scalar * partials[i] );
+            }
+        }
+
+        Sink& sink;
+        const Partials& partials;
+        const Constants& constants;
+        double scalar;
+    };
+
+    /** Operand expressions */
+    Operands operands_;
+
+    /** Computed expression value */
+    double value_;
+
+    /** Partials w.r.t. the operands */
+    Partials partials_;
+
+    /** Operands known to have no parameters, skipped when propagating partials */
+    Constants constants_;
+};
+
+
+namespace detail
+{
+
+    /**
+     * @brief Converts a binary operation into an n-ary operation on the same two operands, to be
+     * extended by further operands.
+     *
+     * @tparam Op N-ary operation type
+     * @tparam Left Type of the LHS expression
+     * @tparam Right Type of the RHS expression
+     * @tparam BinaryOp Binary operation type
+     * @param expr Binary operation
+     * @return ScalarNaryOp< Op, Left, Right > N-ary operation with the same value and partials
+     */
+    template< typename Op, typename Left, typename Right, typename BinaryOp >
+    ScalarNaryOp< Op, Left, Right > flatten( const ScalarBinaryOp< Left, Right, BinaryOp >& expr )
+    {
+        return ScalarNaryOp< Op, Left, Right >{ std::forward_as_tuple( expr.left(), expr.right() ),
+            expr.value(), { { expr.leftPartial(), expr.rightPartial() } } };
+    }
+
+} // detail
+
+} // metal
+
+#endif // METAL_SCALARNARYOP_H
@@ -21,11 +21,75 @@ class ScalarUnaryOp;
 template< typename Expr, typename Op >
 struct PartialSegment< ScalarUnaryOp< Expr, Op > >
 {
-    /** Alias for internal type */
-    using Type = decltype( std::declval< typename PartialSegment< Expr >::Type >() * double{} );
+    /** Alias for internal type, evaluated as the sub-expression partial may be a temporary */
+    using Type = EigenRowVector;
 };
 
 
+/**
+ * @brief Value and local partial derivative of a unary operation, computed together.
+ *
+ */
+struct UnaryResult
+{
+    /** Value of the operation */
+    double value;
+
+    /** Partial derivative w.r.t. the operand */
+    double partial;
+};
+
+
+namespace detail
+{
+
+    /**
+     * @brief Applies a unary operation implementing the fused `UnaryResult apply( double )`
+     * method.
+     *
+     * @tparam Op Type of the operation
+     * @param op Operation
+     * @param value Value of the operand
+     * @return UnaryResult Value and partial
+     */
+    template< typename Op >
+    auto applyUnary( const Op& op, double value, int ) -> decltype( op.apply( value ) )
+    {
+        return op.apply( value );
+    }
+
+    /**
+     * @brief Applies a unary operation implementing separate `applyToValue` and `partial`
+     * methods.
+     *
+     * @tparam Op Type of the operation
+     * @param op Operation
+     * @param value Value of the operand
+     * @return UnaryResult Value and partial
+     */
+    template< typename Op >
+    UnaryResult applyUnary( const Op& op, double value, long )
+    {
+        return UnaryResult{ op.applyToValue( value ), op.partial( value ) };
+    }
+
+    /**
+     * @brief Applies a unary operation, using the fused protocol if the operation implements it.
+     *
+     * @tparam Op Type of the operation
+     * @param op Operation
+     * @param value Value of the operand
+     * @return UnaryResult Value and partial
+     */
+    template< typename Op >
+    UnaryResult applyUnary( const Op& op, double value )
+    {
+        return applyUnary( op, value, 0 );
+    }
+
+} // detail
+
+
 /**
  * @brief Proxy ET type to represent a unary operation in which exactly one other expression
  * (scalar) take part in.
@@ -34,6 +98,10 @@ struct PartialSegment< ScalarUnaryOp< Expr, Op > >
  * derivative vector expression is cached at construction, as the dimension has to be the same
  * as the incoming expression (since there is no source of additional parameters).
  *
+ * Operations preferably implement `UnaryResult apply( double value ) const`, returning the value
+ * and the partial together, so that work shared between them is done only once. Operations
+ * implementing `applyToValue` and `partial` separately are supported as well.
+ *
  * @tparam Expr Type of expression the unary operation acts on
  * @tparam Op Type of operation to be applied on the expression
  */
@@ -54,11 +122,7 @@ public:
      * @param op Operation that defines the transformation
      */
     ScalarUnaryOp( const Expr& expr, const Op& op )
-        : expr_( expr )
-        , op_( op )
-        , cache_{ expr_.value() }
-        , value_{ op_.applyToValue( cache_ ) }
-        , partial_{ op_.partial( cache_ ) }
+        : ScalarUnaryOp{ expr, detail::applyUnary( op, expr.value() ) }
     {
     }
 
@@ -112,7 +176,6 @@ public:
             throw std::runtime_error( "Error! Parameter not present in partials: '"
                 + ( p ? p->name() : "NULLPTR" ) + "'" );
         }
-        // return partial_.segment( expr_.parameterMap().at( p ), p->dim() );
         return expr_.at( p ) * partial_;
     }
 
@@ -132,16 +195,32 @@ public:
         expr_.accum( partial, scalar * partial_, p );
     }
 
+    /**
+     *  @copydoc ScalarBase::scatter()
+     */
+    template< typename Sink >
+    void scatter( Sink& sink, double scalar ) const
+    {
+        expr_.scatter( sink, scalar * partial_ );
+    }
+
 private:
+    /**
+     * @brief Construct a new Scalar Unary Op object from the already computed value and partial.
+     *
+     * @param expr Expression as input for an operator to transform
+     * @param result Value and partial of the operation
+     */
+    ScalarUnaryOp( const Expr& expr, const UnaryResult& result )
+        : expr_( expr )
+        , value_{ result.value }
+        , partial_{ result.partial }
+    {
+    }
+
     /** Internal expression to apply the unary operator on */
     typename RefTypeSelector< Expr >::Type expr_;
 
-    /** Operation to apply on the expression */
-    Op op_;
-
-    /** Cached sub-expression value */
-    double cache_;
-
     /** Computed expression value */
     double value_;
 
@@ -0,0 +1,876 @@
+#ifndef METAL_SCATTERSINK_H
+#define METAL_SCATTERSINK_H
+
+
+#include "src/ParameterLayout.h"
+#include "src/PartialVector.h"
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+
+namespace metal
+{
+
+namespace detail
+{
+
+    /**
+     * @brief Returns the number of stored elements of a dense Eigen partial vector.
+     *
+     * @tparam Derived Type of the Eigen vector
+     * @param partial Partial vector
+     * @return int Number of elements
+     */
+    template< typename Derived >
+    int nonZeros( const Eigen::MatrixBase< Derived >& partial )
+    {
+        return static_cast< int >( partial.size() );
+    }
+
+    /**
+     * @brief Returns the number of stored elements of a partial vector.
+     *
+     * @param partial Partial vector
+     * @return int Number of stored elements
+     */
+    inline int nonZeros( const PartialVector& partial )
+    {
+        return partial.nonZeros();
+    }
+
+    /**
+     * @brief Adds a weighted part of a dense Eigen partial vector to a dense target.
+     *
+     * @tparam Derived Type of the Eigen vector
+     * @param partial Partial vector
+     * @param target Pointer to the first target element
+     * @param start Index of the first element
+     * @param size Number of elements
+     * @param scalar Weight
+     */
+    template< typename Derived >
+    void addTo( const Eigen::MatrixBase< Derived >& partial, double* target, int start, int size,
+        double scalar )
+    {
+        PartialVector::Map{ target, size } += scalar * partial.segment( start, size );
+    }
+
+    /**
+     * @brief Adds a weighted part of a partial vector to a dense target.
+     *
+     * @param partial Partial vector
+     * @param target Pointer to the first target element
+     * @param start Index of the first element
+     * @param size Number of elements
+     * @param scalar Weight
+     */
+    inline void addTo(
+        const PartialVector& partial, double* target, int start, int size, double scalar )
+    {
+        partial.addTo( target, start, size, scalar );
+    }
+
+    /**
+     * @brief Calls a function with the relative index and value of the non-zero elements of a
+     * part of a dense Eigen partial vector.
+     *
+     * @tparam Derived Type of the Eigen vector
+     * @tparam Func Type of the function
+     * @param partial Partial vector
+     * @param start Index of the first element
+     * @param size Number of elements
+     * @param func Function taking the index relative to start and the value
+     */
+    template< typename Derived, typename Func >
+    void visit( const Eigen::MatrixBase< Derived >& partial, int start, int size, Func&& func )
+    {
+        for ( int i = 0; i < size; i++ )
+        {
+            if ( std::fabs( partial[start + i] ) <= 0.0 )
+            {
+                continue;
+            }
+            func( i, partial[start + i] );
+        }
+    }
+
+    /**
+     * @brief Calls a function with the relative index and value of the stored elements of a part
+     * of a partial vector.
+     *
+     * @tparam Func Type of the function
+     * @param partial Partial vector
+     * @param start Index of the first element
+     * @param size Number of elements
+     * @param func Function taking the index relative to start and the value
+     */
+    template< typename Func >
+    void visit( const PartialVector& partial, int start, int size, Func&& func )
+    {
+        partial.visit( start, size, std::forward< Func >( func ) );
+    }
+
+    /**
+     * @brief Adds a whole weighted Eigen partial vector to an Eigen target of the same size. Fixed
+     * size vectors are unrolled.
+     *
+     * @tparam Target Type of the target vector
+     * @tparam Derived Type of the source vector
+     * @param target Target vector
+     * @param partial Source vector
+     * @param scalar Weight
+     */
+    template< typename Target, typename Derived >
+    void addWhole( Eigen::MatrixBase< Target >& target, const Eigen::MatrixBase< Derived >& partial,
+        double scalar )
+    {
+        target += scalar * partial;
+    }
+
+    /**
+     * @brief Adds a whole weighted partial vector to an Eigen target of the same size.
+     *
+     * @tparam Target Type of the target vector
+     * @param target Target vector
+     * @param partial Source vector
+     * @param scalar Weight
+     */
+    template< typename Target >
+    void addWhole(
+        Eigen::MatrixBase< Target >& target, const PartialVector& partial, double scalar )
+    {
+        partial.addTo( target.derived().data(), 0, partial.size(), scalar );
+    }
+
+    /**
+     * @brief Adds a whole weighted Eigen partial vector to a dense partial vector of the same
+     * size.
+     *
+     * @tparam Derived Type of the source vector
+     * @param target Target vector
+     * @param partial Source vector
+     * @param scalar Weight
+     */
+    template< typename Derived >
+    void addWhole(
+        PartialVector& target, const Eigen::MatrixBase< Derived >& partial, double scalar )
+    {
+        target.map() += scalar * partial;
+    }
+
+    /**
+     * @brief Adds a whole weighted partial vector to a dense partial vector of the same size.
+     *
+     * @param target Target vector
+     * @param partial Source vector
+     * @param scalar Weight
+     */
+    inline void addWhole( PartialVector& target, const PartialVector& partial, double scalar )
+    {
+        partial.addTo( target.data(), 0, partial.size(), scalar );
+    }
+
+    /**
+     * @brief Type trait for the compile-time size of a partial vector, dynamic unless it is a
+     * fixed size Eigen vector.
+     *
+     * @tparam Vector Type of the partial vector
+     */
+    template< typename Vector >
+    struct FixedSize : std::integral_constant< int, Eigen::Dynamic >
+    {
+    };
+
+    /**
+     * @brief Compile-time size of an Eigen row vector.
+     *
+     */
+    template< int Rows, int Cols, int Options, int MaxRows, int MaxCols >
+    struct FixedSize< Eigen::Matrix< double, Rows, Cols, Options, MaxRows, MaxCols > >
+        : std::integral_constant< int, Cols >
+    {
+    };
+
+    /**
+     * @brief Type trait telling whether a leaf partial vector can be added as a whole to a target,
+     * i.e. whether their sizes are not fixed to different ones. Leaves of another fixed size never
+     * share the layout of the target.
+     *
+     * @tparam Target Type of the target vector
+     * @tparam Source Type of the leaf partial vector
+     */
+    template< typename Target, typename Source >
+    struct FitsWhole : std::integral_constant< bool,
+                           FixedSize< Target >::value == Eigen::Dynamic
+                               || FixedSize< Source >::value == Eigen::Dynamic
+                               || FixedSize< Target >::value == FixedSize< Source >::value >
+    {
+    };
+
+    /**
+     * @brief Adds a whole weighted leaf partial vector that fits the target, see \ref addWhole.
+     *
+     * @tparam Target Type of the target vector
+     * @tparam Source Type of the leaf partial vector
+     * @param target Target vector
+     * @param partial Source vector
+     * @param scalar Weight
+     */
+    template< typename Target, typename Source >
+    void addFitting( Target& target, const Source& partial, double scalar, std::true_type )
+    {
+        addWhole( target, partial, scalar );
+    }
+
+    /**
+     * @brief Never called, as leaf partial vectors of another fixed size do not share the target
+     * layout.
+     *
+     */
+    template< typename Target, typename Source >
+    void addFitting( Target&, const Source&, double, std::false_type )
+    {
+    }
+
+    /**
+     * @brief Returns whether a dense Eigen partial vector stores all elements, which is always the
+     * case.
+     *
+     * @tparam Derived Type of the Eigen vector
+     * @return true Always
+     */
+    template< typename Derived >
+    bool isDense( const Eigen::MatrixBase< Derived >& )
+    {
+        return true;
+    }
+
+    /**
+     * @brief Returns whether a partial vector is stored in dense mode.
+     *
+     * @param partial Partial vector
+     * @return true The vector is dense
+     * @return false The vector is sparse
+     */
+    inline bool isDense( const PartialVector& partial )
+    {
+        return !partial.isSparse();
+    }
+
+    /**
+     * @brief Assigns a whole weighted Eigen partial vector to a dense partial vector of the same
+     * size.
+     *
+     * @tparam Derived Type of the source vector
+     * @param target Target vector
+     * @param partial Source vector
+     * @param scalar Weight
+     */
+    template< typename Derived >
+    void assignWhole(
+        PartialVector& target, const Eigen::MatrixBase< Derived >& partial, double scalar )
+    {
+        target.map() = scalar * partial;
+    }
+
+    /**
+     * @brief Assigns a whole weighted dense partial vector to a dense partial vector of the same
+     * size.
+     *
+     * @param target Target vector
+     * @param partial Source vector, in dense mode
+     * @param scalar Weight
+     */
+    inline void assignWhole( PartialVector& target, const PartialVector& partial, double scalar )
+    {
+        target.map() = scalar * partial.map();
+    }
+
+    /**
+     * @brief Sink receiving the leaf contributions of an expression through
+     * \ref ScalarBase::scatter, adding them to a dense partial vector with a given layout.
+     *
+     * Leaves have to provide their layout via a `layout()` method and their partial vector via a
+     * `partial()` method. The layout of every leaf has to be a subset of the target layout.
+     *
+     * @tparam Target Type of the target partial vector
+     */
+    template< typename Target >
+    class ScatterSink
+    {
+
+    public:
+        /**
+         * @brief Construct a new Scatter Sink object.
+         *
+         * @param partial Target partial vector, in dense mode
+         * @param layout Layout of the target vector
+         */
+        ScatterSink( Target& partial, const ParameterLayout& layout )
+            : partial_( partial )
+            , layout_( layout )
+        {
+        }
+
+        /**
+         * @brief Adds the weighted partials of a leaf to the target vector.
+         *
+         * @tparam Leaf Type of the leaf
+         * @param leaf Leaf of the expression
+         * @param scalar Weight of the leaf
+         */
+        template< typename Leaf >
+        void operator()( const Leaf& leaf, double scalar )
+        {
+            const LayoutPtr& layout = leaf.layout();
+            if ( !layout )
+            {
+                return;
+            }
+            using Source = typename std::decay< decltype( leaf.partial() ) >::type;
+            using Fits = FitsWhole< Target, Source >;
+            if ( Fits::value && layout.get() == &layout_ )
+            {
+                addFitting( partial_, leaf.partial(), scalar, Fits{} );
+                return;
+            }
+            // Both layouts are sorted by identifier, so their parameters are matched by merging
+            size_t j = layout_.find( layout->id( 0 ) );
+            for ( size_t i = 0; i < layout->size(); i++ )
+            {
+                while ( layout_.id( j ) != layout->id( i ) )
+                {
+                    ++j;
+                }
+                addTo( leaf.partial(), partial_.data() + layout_.offset( j ), layout->offset( i ),
+                    layout->dim( i ), scalar );
+            }
+        }
+
+    private:
+        /** Target partial vector */
+        Target& partial_;
+
+        /** Layout of the target vector */
+        const ParameterLayout& layout_;
+    };
+
+    /**
+     * @brief Sink collecting the layouts of the leaves of an expression, so that the parameters
+     * of the expression are merged once at the root of the evaluation. Expression nodes do not
+     * merge parameters themselves.
+     *
+     * The stored partial elements of the leaves are counted in the same pass, which is an upper
+     * bound of the non-zeros of the evaluated partial vector.
+     *
+     */
+    class LayoutSink
+    {
+
+    public:
+        /**
+         * @brief Collects the layout of a leaf and counts its stored partial elements.
+         *
+         * @tparam Leaf Type of the leaf
+         * @param leaf Leaf of the expression
+         */
+        template< typename Leaf >
+        void operator()( const Leaf& leaf, double )
+        {
+            const LayoutPtr& layout = leaf.layout();
+            if ( layout )
+            {
+                add( layout, nonZeros( leaf.partial() ) );
+            }
+        }
+
+        /**
+         * @brief Collects a layout, unless it is the same as the previous one, and adds to the
+         * count.
+         *
+         * @param layout Layout, owned by a leaf
+         * @param count Number of stored partial elements
+         */
+        void add( const LayoutPtr& layout, int count )
+        {
+            if ( layouts_.empty() || *layouts_.back() != layout )
+            {
+                layouts_.push_back( &layout );
+            }
+            count_ += count;
+        }
+
+        /**
+         * @brief Returns the union of the collected layouts.
+         *
+         * @return LayoutPtr Union layout, null pointer if no leaf has partials
+         */
+        LayoutPtr layout() const
+        {
+            return ParameterLayout::merge( layouts_ );
+        }
+
+        /**
+         * @brief Returns the extent of the union of the collected layouts, without creating it.
+         *
+         * @return ParameterLayout::Extent Number of parameters and total dimension
+         */
+        ParameterLayout::Extent extent() const
+        {
+            return ParameterLayout::extent( layouts_ );
+        }
+
+        /**
+         * @brief Returns the number of stored partial elements counted.
+         *
+         * @return int Number of elements
+         */
+        int count() const
+        {
+            return count_;
+        }
+
+    private:
+        /** Layouts of the leaves, owned by the leaves */
+        std::vector< const LayoutPtr* > layouts_;
+
+        /** Number of stored partial elements counted */
+        int count_ = 0;
+    };
+
+    /**
+     * @brief Returns the layout of the union of the parameters of all leaves of an expression.
+     *
+     * @tparam Expr Type of the expression
+     * @param expr Expression to get the layout of
+     * @return LayoutPtr Union layout, null pointer if no leaf has partials
+     */
+    template< typename Expr >
+    LayoutPtr layoutOf( const ScalarBase< Expr >& expr )
+    {
+        LayoutSink sink;
+        expr.scatter( sink, 1.0 );
+        return sink.layout();
+    }
+
+    /**
+     * @brief Returns the number of parameters and total dimension of the union of the parameters
+     * of all leaves of an expression, without creating its layout.
+     *
+     * @tparam Expr Type of the expression
+     * @param expr Expression to get the extent of
+     * @return ParameterLayout::Extent Extent of the union layout
+     */
+    template< typename Expr >
+    ParameterLayout::Extent extentOf( const ScalarBase< Expr >& expr )
+    {
+        LayoutSink sink;
+        expr.scatter( sink, 1.0 );
+        return sink.extent();
+    }
+
+    /**
+     * @brief Sink collecting the weighted non-zero partial elements of the leaves of an expression
+     * as index/value pairs w.r.t. a given layout. The pairs are merged when assigned to a partial
+     * vector via \ref PartialVector::setSparse.
+     *
+     */
+    class SparseSink
+    {
+
+    public:
+        /**
+         * @brief Construct a new Sparse Sink object.
+         *
+         * @param layout Layout of the target vector
+         * @param capacity Expected number of pairs
+         */
+        SparseSink( const ParameterLayout& layout, int capacity )
+            : layout_( layout )
+        {
+            entries_.reserve( static_cast< size_t >( capacity ) );
+        }
+
+        /**
+         * @brief Collects the weighted non-zero partials of a leaf.
+         *
+         * @tparam Leaf Type of the leaf
+         * @param leaf Leaf of the expression
+         * @param scalar Weight of the leaf
+         */
+        template< typename Leaf >
+        void operator()( const Leaf& leaf, double scalar )
+        {
+            const LayoutPtr& layout = leaf.layout();
+            if ( !layout )
+            {
+                return;
+            }
+            size_t j = layout_.find( layout->id( 0 ) );
+            for ( size_t i = 0; i < layout->size(); i++ )
+            {
+                while ( layout_.id( j ) != layout->id( i ) )
+                {
+                    ++j;
+                }
+                const int offset = layout_.offset( j );
+                visit( leaf.partial(), layout->offset( i ), layout->dim( i ),
+                    [&]( int k, double v ) { entries_.emplace_back( offset + k, scalar * v ); } );
+            }
+        }
+
+        /**
+         * @brief Returns the collected index/value pairs.
+         *
+         * @return std::vector< PartialVector::Entry >& Unsorted pairs, possibly with duplicates
+         */
+        std::vector< PartialVector::Entry >& entries()
+        {
+            return entries_;
+        }
+
+    private:
+        /** Layout of the target vector */
+        const ParameterLayout& layout_;
+
+        /** Collected index/value pairs */
+        std::vector< PartialVector::Entry > entries_;
+    };
+
+    /**
+     * @brief Sink evaluating an expression whose leaves with partials all share the same layout
+     * and store dense partials, which is the common case for the elements of a state vector.
+     *
+     * The result partial vector is then the weighted sum of the leaf partial vectors, computed
+     * with whole-vector Eigen operations without matching any parameters. The first leaf is
+     * assigned, so that the result is not zeroed beforehand. As soon as a leaf with a different
+     * layout or sparse partials is found, the sink stops adding partials and reports the
+     * mismatch. The layouts and stored elements of all leaves are passed on to a \ref LayoutSink
+     * in the same pass, so that the expression can then be evaluated in the general way without
+     * traversing it once more for its layout.
+     *
+     */
+    class SameLayoutSink
+    {
+
+    public:
+        /**
+         * @brief Construct a new Same Layout Sink object.
+         *
+         * @param partial Target partial vector, resized by the first leaf with partials
+         * @param layouts Sink collecting the layouts of the leaves in case of a mismatch
+         */
+        SameLayoutSink( PartialVector& partial, LayoutSink& layouts )
+            : partial_( partial )
+            , layouts_( layouts )
+        {
+        }
+
+        /**
+         * @brief Assigns or adds the weighted partials of a leaf to the target vector.
+         *
+         * @tparam Leaf Type of the leaf
+         * @param leaf Leaf of the expression
+         * @param scalar Weight of the leaf
+         */
+        template< typename Leaf >
+        void operator()( const Leaf& leaf, double scalar )
+        {
+            const LayoutPtr& layout = leaf.layout();
+            if ( !layout )
+            {
+                return;
+            }
+            if ( !matches_ )
+            {
+                layouts_( leaf, scalar );
+                return;
+            }
+            if ( !isDense( leaf.partial() ) || ( layout_ && layout != *layout_ ) )
+            {
+                matches_ = false;
+                if ( layout_ )
+                {
+                    layouts_.add( *layout_, count_ );
+                }
+                layouts_( leaf, scalar );
+                return;
+            }
+            count_ += nonZeros( leaf.partial() );
+            if ( layout_ )
+            {
+                addWhole( partial_, leaf.partial(), scalar );
+                return;
+            }
+            layout_ = &layout;
+            partial_.resize( layout->dim() );
+            assignWhole( partial_, leaf.partial(), scalar );
+        }
+
+        /**
+         * @brief Returns whether all leaves with partials share the same layout and are dense.
+         *
+         * @return true The target vector holds the evaluated partials
+         * @return false The expression has to be evaluated in the general way
+         */
+        bool matches() const
+        {
+            return matches_;
+        }
+
+        /**
+         * @brief Returns the layout shared by the leaves.
+         *
+         * @return LayoutPtr Shared layout, null pointer if no leaf has partials
+         */
+        LayoutPtr layout() const
+        {
+            return layout_ ? *layout_ : LayoutPtr{};
+        }
+
+    private:
+        /** Target partial vector */
+        PartialVector& partial_;
+
+        /** Sink collecting the layouts of the leaves after a mismatch */
+        LayoutSink& layouts_;
+
+        /** Layout of the first leaf with partials, owned by that leaf */
+        const LayoutPtr* layout_ = nullptr;
+
+        /** Number of stored partial elements of the matching leaves */
+        int count_ = 0;
+
+        /** Whether all leaves seen so far match */
+        bool matches_ = true;
+    };
+
+    /**
+     * @brief Sink evaluating an expression into a zeroed partial vector of fixed size, whose
+     * leaves with partials all share the same layout of that dimension.
+     *
+     * The weighted leaf partials, sparse ones included, are added with whole-vector Eigen
+     * operations that are unrolled for the fixed size, so nothing is allocated and no parameters
+     * are matched. As soon as a leaf with a different layout is found, the sink stops adding
+     * partials and passes the layouts of all leaves on to a \ref LayoutSink, like
+     * \ref SameLayoutSink.
+     *
+     * @tparam Target Type of the fixed size target partial vector
+     */
+    template< typename Target >
+    class FixedLayoutSink
+    {
+
+    public:
+        /**
+         * @brief Construct a new Fixed Layout Sink object.
+         *
+         * @param partial Target partial vector, zeroed
+         * @param layouts Sink collecting the layouts of the leaves in case of a mismatch
+         */
+        FixedLayoutSink( Target& partial, LayoutSink& layouts )
+            : partial_( partial )
+            , layouts_( layouts )
+        {
+        }
+
+        /**
+         * @brief Adds the weighted partials of a leaf to the target vector.
+         *
+         * @tparam Leaf Type of the leaf
+         * @param leaf Leaf of the expression
+         * @param scalar Weight of the leaf
+         */
+        template< typename Leaf >
+        void operator()( const Leaf& leaf, double scalar )
+        {
+            const LayoutPtr& layout = leaf.layout();
+            if ( !layout )
+            {
+                return;
+            }
+            if ( !matches_ )
+            {
+                layouts_( leaf, scalar );
+                return;
+            }
+            using Source = typename std::decay< decltype( leaf.partial() ) >::type;
+            using Fits = FitsWhole< Target, Source >;
+            if ( Fits::value && !layout_ && layout->dim() == partial_.size() )
+            {
+                layout_ = &layout;
+            }
+            if ( !Fits::value || !layout_ || layout != *layout_ )
+            {
+                matches_ = false;
+                if ( layout_ )
+                {
+                    layouts_.add( *layout_, count_ );
+                }
+                layouts_( leaf, scalar );
+                return;
+            }
+            count_ += nonZeros( leaf.partial() );
+            addFitting( partial_, leaf.partial(), scalar, Fits{} );
+        }
+
+        /**
+         * @brief Returns whether all leaves with partials share the same layout of the target
+         * dimension.
+         *
+         * @return true The target vector holds the evaluated partials
+         * @return false The expression has to be evaluated in the general way
+         */
+        bool matches() const
+        {
+            return matches_;
+        }
+
+        /**
+         * @brief Returns the layout shared by the leaves.
+         *
+         * @return LayoutPtr Shared layout, null pointer if no leaf has partials
+         */
+        LayoutPtr layout() const
+        {
+            return layout_ ? *layout_ : LayoutPtr{};
+        }
+
+    private:
+        /** Target partial vector */
+        Target& partial_;
+
+        /** Sink collecting the layouts of the leaves after a mismatch */
+        LayoutSink& layouts_;
+
+        /** Layout of the first leaf with partials, owned by that leaf */
+        const LayoutPtr* layout_ = nullptr;
+
+        /** Number of stored partial elements of the matching leaves */
+        int count_ = 0;
+
+        /** Whether all leaves seen so far match */
+        bool matches_ = true;
+    };
+
+    /**
+     * @brief Sink summing the weights of one particular leaf object in an expression, used to
+     * find out whether an expression refers to the scalar it is assigned to.
+     *
+     */
+    class LeafWeightSink
+    {
+
+    public:
+        /**
+         * @brief Construct a new Leaf Weight Sink object.
+         *
+         * @param leaf Address of the leaf to look for
+         */
+        explicit LeafWeightSink( const void* leaf )
+            : leaf_( leaf )
+        {
+        }
+
+        /**
+         * @brief Adds the weight if the leaf is the one looked for.
+         *
+         * @tparam Leaf Type of the leaf
+         * @param leaf Leaf of the expression
+         * @param scalar Weight of the leaf
+         */
+        template< typename Leaf >
+        void operator()( const Leaf& leaf, double scalar )
+        {
+            if ( static_cast< const void* >( &leaf ) == leaf_ )
+            {
+                found_ = true;
+                weight_ += scalar;
+            }
+        }
+
+        /**
+         * @brief Returns whether the leaf occurs in the expression.
+         *
+         * @return true The leaf was found
+         * @return false The leaf was not found
+         */
+        bool found() const
+        {
+            return found_;
+        }
+
+        /**
+         * @brief Returns the total weight of the leaf in the expression.
+         *
+         * @return double Sum of the weights of all occurrences
+         */
+        double weight() const
+        {
+            return weight_;
+        }
+
+    private:
+        /** Address of the leaf to look for */
+        const void* leaf_;
+
+        /** Whether the leaf was found */
+        bool found_ = false;
+
+        /** Sum of the weights of the leaf */
+        double weight_ = 0.0;
+    };
+
+    /**
+     * @brief Sink forwarding the leaf contributions of an expression to another sink, except the
+     * ones of a particular leaf object.
+     *
+     * @tparam Sink Type of the sink to forward to
+     */
+    template< typename Sink >
+    class SkipLeafSink
+    {
+
+    public:
+        /**
+         * @brief Construct a new Skip Leaf Sink object.
+         *
+         * @param sink Sink to forward to
+         * @param leaf Address of the leaf to skip
+         */
+        SkipLeafSink( Sink& sink, const void* leaf )
+            : sink_( sink )
+            , leaf_( leaf )
+        {
+        }
+
+        /**
+         * @brief Forwards the contribution of a leaf unless it is the skipped one.
+         *
+         * @tparam Leaf Type of the leaf
+         * @param leaf Leaf of the expression
+         * @param scalar Weight of the leaf
+         */
+        template< typename Leaf >
+        void operator()( const Leaf& leaf, double scalar )
+        {
+            if ( static_cast< const void* >( &leaf ) != leaf_ )
+            {
+                sink_( leaf, scalar );
+            }
+        }
+
+    private:
+        /** Sink to forward to */
+        Sink& sink_;
+
+        /** Address of the leaf to skip */
+        const void* leaf_;
+    };
+
+} // detail
+
+} // metal
+
+#endif // METAL_SCATTERSINK_H
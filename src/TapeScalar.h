@@ -0,0 +1,564 @@
+#ifndef METAL_TAPESCALAR_H
+#define METAL_TAPESCALAR_H
+
+
+#include "src/ParameterLayout.h"
+#include "src/ScalarBase.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+
+namespace metal
+{
+
+class TapeScalar;
+
+
+/**
+ * @brief Type trait for the partial segment type of a tape scalar.
+ *
+ */
+template<>
+struct PartialSegment< TapeScalar >
+{
+    /** Alias for internal type */
+    using Type = EigenRowVector;
+};
+
+
+/**
+ * @brief Contiguous record of the operations on \ref TapeScalar objects, used for reverse-mode
+ * derivative computation.
+ *
+ * Every recorded node stores the local partials w.r.t. the nodes it was computed from. Nodes
+ * without inputs are independent variables. There is one tape per thread.
+ */
+class Tape
+{
+
+public:
+    /**
+     * @brief Edge of the computational graph: an input node and the local partial w.r.t. it.
+     *
+     */
+    struct Edge
+    {
+        /** Index of the input node */
+        int node;
+
+        /** Local partial derivative w.r.t. the input node */
+        double weight;
+    };
+
+
+    /**
+     * @brief Returns the tape of the current thread.
+     *
+     * @return Tape& Thread-local tape
+     */
+    static Tape& local()
+    {
+        static thread_local Tape tape;
+        return tape;
+    }
+
+    /**
+     * @brief Records a new independent variable.
+     *
+     * @param name Name of the independent variable
+     * @return int Index of the new node
+     */
+    int addIndependent( const std::string& name )
+    {
+        names_.push_back( name );
+        independents_.push_back( static_cast< int >( begin_.size() ) - 1 );
+        begin_.push_back( begin_.back() );
+        return independents_.back();
+    }
+
+    /**
+     * @brief Records a new node computed from the edges added since the last recorded node.
+     *
+     * @return int Index of the new node
+     */
+    int addNode()
+    {
+        begin_.push_back( static_cast< int >( edges_.size() ) );
+        return static_cast< int >( begin_.size() ) - 2;
+    }
+
+    /**
+     * @brief Adds an edge to the node being recorded.
+     *
+     * @param node Index of the input node
+     * @param weight Local partial derivative w.r.t. the input node
+     */
+    void addEdge( int node, double weight )
+    {
+        edges_.push_back( Edge{ node, weight } );
+    }
+
+    /**
+     * @brief Returns the number of edges added since the last recorded node.
+     *
+     * @return int Number of pending edges
+     */
+    int pending() const
+    {
+        return static_cast< int >( edges_.size() ) - begin_.back();
+    }
+
+    /**
+     * @brief Returns the number of recorded nodes.
+     *
+     * @return int Number of nodes
+     */
+    int size() const
+    {
+        return static_cast< int >( begin_.size() ) - 1;
+    }
+
+    /**
+     * @brief Returns the number of independent variables.
+     *
+     * @return int Number of independent variables
+     */
+    int independents() const
+    {
+        return static_cast< int >( independents_.size() );
+    }
+
+    /**
+     * @brief Returns the position of an independent variable in the gradients.
+     *
+     * @param name Name of the independent variable, the first one created is found for repeated
+     * names
+     * @return int Position of the independent variable
+     */
+    int find( const std::string& name ) const
+    {
+        const auto it = std::find( names_.begin(), names_.end(), name );
+        if ( it == names_.end() )
+        {
+            throw std::runtime_error(
+                "Error! Independent variable not present on the tape: '" + name + "'" );
+        }
+        return static_cast< int >( it - names_.begin() );
+    }
+
+    /**
+     * @brief Computes the partials of a node w.r.t. all the independent variables with a single
+     * reverse sweep over the tape.
+     *
+     * @param node Index of the node, negative for constants
+     * @return Eigen::VectorXd Partials in the order of creation of the independent variables
+     */
+    Eigen::VectorXd gradient( int node ) const
+    {
+        Eigen::VectorXd out = Eigen::VectorXd::Zero( independents() );
+        if ( node < 0 )
+        {
+            return out;
+        }
+
+        adjoints_.assign( static_cast< size_t >( node ) + 1, 0.0 );
+        adjoints_.back() = 1.0;
+        for ( int i = node; i >= 0; i-- )
+        {
+            const double adjoint = adjoints_[static_cast< size_t >( i )];
+            if ( std::fabs( adjoint ) <= 0.0 )
+            {
+                continue;
+            }
+            for ( int k = begin_[static_cast< size_t >( i )];
+                  k < begin_[static_cast< size_t >( i ) + 1]; k++ )
+            {
+                const Edge& edge = edges_[static_cast< size_t >( k )];
+                adjoints_[static_cast< size_t >( edge.node )] += adjoint * edge.weight;
+            }
+        }
+
+        for ( int j = 0; j < independents(); j++ )
+        {
+            const int index = independents_[static_cast< size_t >( j )];
+            if ( index <= node )
+            {
+                out[j] = adjoints_[static_cast< size_t >( index )];
+            }
+        }
+        return out;
+    }
+
+    /**
+     * @brief Removes all recorded nodes, keeping the allocated memory. Tape scalars recorded
+     * before are invalidated.
+     *
+     */
+    void clear()
+    {
+        begin_.assign( 1, 0 );
+        edges_.clear();
+        independents_.clear();
+        names_.clear();
+    }
+
+private:
+    Tape()
+        : begin_( 1, 0 )
+        , edges_{}
+        , independents_{}
+        , names_{}
+        , adjoints_{}
+    {
+    }
+
+    /** Position of the first edge of every node, with the total number of edges as last element */
+    std::vector< int > begin_;
+
+    /** Edges of all the nodes */
+    std::vector< Edge > edges_;
+
+    /** Node indices of the independent variables */
+    std::vector< int > independents_;
+
+    /** Names of the independent variables */
+    std::vector< std::string > names_;
+
+    /** Work storage of the reverse sweep */
+    mutable std::vector< double > adjoints_;
+};
+
+
+namespace detail
+{
+
+    /**
+     * @brief Sink receiving the leaf contributions of an expression through
+     * \ref ScalarBase::scatter, recording them as edges on a tape. Leaves other than tape scalars
+     * are constants for the tape.
+     *
+     */
+    class TapeSink
+    {
+
+    public:
+        /**
+         * @brief Construct a new Tape Sink object.
+         *
+         * @param tape Tape to record to
+         */
+        explicit TapeSink( Tape& tape )
+            : tape_( tape )
+        {
+        }
+
+        /**
+         * @brief Records the partial w.r.t. a tape scalar leaf.
+         *
+         * @param leaf Leaf of the expression
+         * @param scalar Partial of the expression w.r.t. the leaf
+         */
+        void operator()( const TapeScalar& leaf, double scalar );
+
+        /**
+         * @brief Ignores leaves that are not recorded on the tape.
+         *
+         * @tparam Leaf Type of the leaf
+         */
+        template< typename Leaf >
+        void operator()( const Leaf&, double )
+        {
+        }
+
+    private:
+        /** Tape to record to */
+        Tape& tape_;
+    };
+
+} // detail
+
+
+/**
+ * @brief Concrete final type of the ET design architecture computing derivatives in reverse mode.
+ *
+ * Instead of carrying partial derivative vectors, every scalar evaluated from an expression
+ * records one node on the thread-local \ref Tape, with the local partials w.r.t. the tape scalars
+ * of the expression. These are computed by the same operators as the forward mode. The partials
+ * w.r.t. all independent variables are obtained by one reverse sweep in \ref gradient, so the
+ * cost does not grow with the number of parameters.
+ *
+ * Tape scalars hold no forward-mode parameters, and can only be used on the thread that recorded
+ * them.
+ */
+class TapeScalar : public ScalarBase< TapeScalar >
+{
+
+public:
+    /** Alias for Eigen segment ET to represent part of the derivative vector */
+    using PartialSegment = typename PartialSegment< TapeScalar >::Type;
+
+
+    /**
+     * @brief Construct a new constant Tape Scalar object, which is not recorded.
+     *
+     * Default for the value is zero.
+     *
+     * @param value Value of the scalar object
+     */
+    explicit TapeScalar( double value = 0.0 )
+        : value_{ value }
+        , index_{ -1 }
+    {
+    }
+
+    /**
+     * @brief Construct a new Tape Scalar object as an independent variable on the tape.
+     *
+     * The partials w.r.t. the independent variables are ordered by their creation, and can be
+     * looked up by name.
+     *
+     * @param value Value of the scalar object
+     * @param name Name of the independent variable
+     */
+    TapeScalar( double value, const std::string& name )
+        : value_{ value }
+        , index_{ Tape::local().addIndependent( name ) }
+    {
+    }
+
+    /**
+     * @brief Construct a new Tape Scalar object from an existing expression by recording one node
+     * with the partials w.r.t. the tape scalars of the expression.
+     *
+     * @tparam Expr Type of expression to evaluate
+     * @param expr Expression to evaluate
+     */
+    template< typename Expr >
+    TapeScalar( const ScalarBase< Expr >& expr )
+        : value_{ expr.value() }
+        , index_{ -1 }
+    {
+        Tape& tape = Tape::local();
+        detail::TapeSink sink{ tape };
+        expr.scatter( sink, 1.0 );
+        if ( tape.pending() )
+        {
+            index_ = tape.addNode();
+        }
+    }
+
+    /**
+     *  @copydoc ScalarBase::value()
+     */
+    double value() const
+    {
+        return value_;
+    }
+
+    /**
+     *  @copydoc ScalarBase::dim()
+     */
+    size_t dim() const
+    {
+        return 0;
+    }
+
+    /**
+     *  @copydoc ScalarBase::size()
+     */
+    size_t size() const
+    {
+        return 0;
+    }
+
+    /**
+     *  @copydoc ScalarBase::parameters()
+     */
+    const ParameterPtrVector& parameters() const
+    {
+        static const ParameterPtrVector empty{};
+        return empty;
+    }
+
+    /**
+     *  @copydoc ScalarBase::contains()
+     */
+    bool contains( const ParameterPtr& ) const
+    {
+        return false;
+    }
+
+    /**
+     *  @copydoc ScalarBase::at()
+     */
+    PartialSegment at( const ParameterPtr& p ) const
+    {
+        throw std::runtime_error( "Error! Parameter not present in partials: '"
+            + ( p ? p->name() : "NULLPTR" ) + "'" );
+    }
+
+    /**
+     *  @copydoc ScalarBase::accum()
+     */
+    void accum( EigenRowVectorSegment&, const ParameterPtr& ) const
+    {
+    }
+
+    /**
+     *  @copydoc ScalarBase::accum()
+     */
+    void accum( EigenRowVectorSegment&, double, const ParameterPtr& ) const
+    {
+    }
+
+    /**
+     *  @copydoc ScalarBase::scatter()
+     */
+    template< typename Sink >
+    void scatter( Sink& sink, double scalar ) const
+    {
+        sink( *this, scalar );
+    }
+
+    /**
+     * @brief Returns the layout of the forward-mode partials, always empty.
+     *
+     * @return const LayoutPtr& Null pointer
+     */
+    const LayoutPtr& layout() const
+    {
+        static const LayoutPtr empty{};
+        return empty;
+    }
+
+    /**
+     * @brief Returns the forward-mode partials, always empty.
+     *
+     * @return const EigenRowVector& Empty vector
+     */
+    const EigenRowVector& partial() const
+    {
+        static const EigenRowVector empty{};
+        return empty;
+    }
+
+    /**
+     * @brief Returns the index of the node on the tape.
+     *
+     * @return int Index of the node, negative for constants
+     */
+    int index() const
+    {
+        return index_;
+    }
+
+    /**
+     * @brief Computes the partials w.r.t. all independent variables on the tape by a reverse
+     * sweep.
+     *
+     * @return Eigen::VectorXd Partials in the order of creation of the independent variables
+     */
+    Eigen::VectorXd gradient() const
+    {
+        return Tape::local().gradient( index_ );
+    }
+
+    /**
+     * @brief Computes the partial w.r.t. a named independent variable by a reverse sweep.
+     *
+     * @param name Name of the independent variable
+     * @return double Partial w.r.t. the independent variable
+     */
+    double gradient( const std::string& name ) const
+    {
+        const Tape& tape = Tape::local();
+        return tape.gradient( index_ )[tape.find( name )];
+    }
+
+    /**
+     * @brief In-place addition operator with a number.
+     *
+     * @param other Floating point value to add
+     * @return TapeScalar& Reference to modified object
+     */
+    TapeScalar& operator+=( double other )
+    {
+        value_ += other;
+        return *this;
+    }
+
+    /**
+     * @brief In-place subtraction operator with a number.
+     *
+     * @param other Floating point value to subtract
+     * @return TapeScalar& Reference to modified object
+     */
+    TapeScalar& operator-=( double other )
+    {
+        value_ -= other;
+        return *this;
+    }
+
+    /**
+     * @brief In-place multiplication operator with a number.
+     *
+     * @param other Floating point value to multiply with
+     * @return TapeScalar& Reference to modified object
+     */
+    TapeScalar& operator*=( double other )
+    {
+        value_ *= other;
+        scale( other );
+        return *this;
+    }
+
+    /**
+     * @brief In-place division operator with a number.
+     *
+     * @param other Floating point value to divide with
+     * @return TapeScalar& Reference to modified object
+     */
+    TapeScalar& operator/=( double other )
+    {
+        value_ /= other;
+        scale( 1.0 / other );
+        return *this;
+    }
+
+private:
+    /**
+     * @brief Records a new node that is this node multiplied by a number.
+     *
+     * @param scalar Multiplier
+     */
+    void scale( double scalar )
+    {
+        if ( index_ >= 0 )
+        {
+            Tape& tape = Tape::local();
+            tape.addEdge( index_, scalar );
+            index_ = tape.addNode();
+        }
+    }
+
+    /** Physical value of the scalar */
+    double value_;
+
+    /** Index of the node on the tape, negative for constants */
+    int index_;
+};
+
+
+inline void detail::TapeSink::operator()( const TapeScalar& leaf, double scalar )
+{
+    if ( leaf.index() >= 0 )
+    {
+        tape_.addEdge( leaf.index(), scalar );
+    }
+}
+
+} // metal
+
+#endif // METAL_TAPESCALAR_H
@@ -104,24 +104,16 @@ ScalarUnaryOp< Expr, CubeOp > cube( const ScalarBase< Expr >& expr )
 struct SquareRootOp
 {
     /**
-     * @brief Applies the transformation on the value of an expression.
+     * @brief Applies the transformation on the value of an expression and computes the partial
+     * derivative of the unary operation. The partial is computed from the value.
      *
      * @param value Value of the expression
-     * @return double Transformed value
-     */
-    double applyToValue( double value ) const
-    {
-        return std::sqrt( value );
-    }
-
-    /**
-     * @brief Computes the partial derivative of the unary operation.
-     *
-     * @return double Partial
+     * @return UnaryResult Transformed value and partial
      */
-    double partial( double value ) const
+    UnaryResult apply( double value ) const
     {
-        return 0.5 / std::sqrt( value );
+        const double tmp = std::sqrt( value );
+        return UnaryResult{ tmp, 0.5 / tmp };
     }
 };
 
@@ -141,6 +133,432 @@ ScalarUnaryOp< Expr, SquareRootOp > sqrt( const ScalarBase< Expr >& expr )
         static_cast< const Expr& >( expr ), SquareRootOp{} );
 }
 
+/**
+ * @brief Unary operation taken by \ref ScalarUnaryOp object to define the expression for
+ * computing the cube root of an expression.
+ */
+struct CubeRootOp
+{
+    /**
+     * @brief Applies the transformation on the value of an expression and computes the partial
+     * derivative of the unary operation. The partial is computed from the value.
+     *
+     * @param value Value of the expression
+     * @return UnaryResult Transformed value and partial
+     */
+    UnaryResult apply( double value ) const
+    {
+        const double tmp = std::cbrt( value );
+        return UnaryResult{ tmp, 1.0 / ( 3.0 * tmp * tmp ) };
+    }
+};
+
+
+/**
+ * @brief Cube root function that takes an expression and creates a new expression with applied
+ * transformation.
+ *
+ * @tparam Expr Type of the expression
+ * @param expr Expression to apply cube root to
+ * @return ScalarUnaryOp< Expr, CubeRootOp > Expression that represents the cube root
+ */
+template< typename Expr >
+ScalarUnaryOp< Expr, CubeRootOp > cbrt( const ScalarBase< Expr >& expr )
+{
+    return ScalarUnaryOp< Expr, CubeRootOp >(
+        static_cast< const Expr& >( expr ), CubeRootOp{} );
+}
+
+/**
+ * @brief Unary operation taken by \ref ScalarUnaryOp object to define the expression for
+ * computing the exponential of an expression.
+ */
+struct ExponentialOp
+{
+    /**
+     * @brief Applies the transformation on the value of an expression and computes the partial
+     * derivative of the unary operation. The partial is equal to the value.
+     *
+     * @param value Value of the expression
+     * @return UnaryResult Transformed value and partial
+     */
+    UnaryResult apply( double value ) const
+    {
+        const double tmp = std::exp( value );
+        return UnaryResult{ tmp, tmp };
+    }
+};
+
+
+/**
+ * @brief Exponential function that takes an expression and creates a new expression with applied
+ * transformation.
+ *
+ * @tparam Expr Type of the expression
+ * @param expr Expression to apply exponential to
+ * @return ScalarUnaryOp< Expr, ExponentialOp > Expression that represents the exponential
+ */
+template< typename Expr >
+ScalarUnaryOp< Expr, ExponentialOp > exp( const ScalarBase< Expr >& expr )
+{
+    return ScalarUnaryOp< Expr, ExponentialOp >(
+        static_cast< const Expr& >( expr ), ExponentialOp{} );
+}
+
+/**
+ * @brief Unary operation taken by \ref ScalarUnaryOp object to define the expression for
+ * computing the exponential minus one of an expression.
+ */
+struct ExponentialMinusOneOp
+{
+    /**
+     * @brief Applies the transformation on the value of an expression and computes the partial
+     * derivative of the unary operation. The partial is computed from the value.
+     *
+     * @param value Value of the expression
+     * @return UnaryResult Transformed value and partial
+     */
+    UnaryResult apply( double value ) const
+    {
+        const double tmp = std::expm1( value );
+        return UnaryResult{ tmp, tmp + 1.0 };
+    }
+};
+
+
+/**
+ * @brief Exponential minus one function that takes an expression and creates a new expression
+ * with applied transformation. It is accurate for values close to zero.
+ *
+ * @tparam Expr Type of the expression
+ * @param expr Expression to apply exponential minus one to
+ * @return ScalarUnaryOp< Expr, ExponentialMinusOneOp > Expression that represents the
+ * exponential minus one
+ */
+template< typename Expr >
+ScalarUnaryOp< Expr, ExponentialMinusOneOp > expm1( const ScalarBase< Expr >& expr )
+{
+    return ScalarUnaryOp< Expr, ExponentialMinusOneOp >(
+        static_cast< const Expr& >( expr ), ExponentialMinusOneOp{} );
+}
+
+/**
+ * @brief Unary operation taken by \ref ScalarUnaryOp object to define the expression for
+ * computing the natural logarithm of an expression.
+ */
+struct LogarithmOp
+{
+    /**
+     * @brief Applies the transformation on the value of an expression and computes the partial
+     * derivative of the unary operation.
+     *
+     * @param value Value of the expression
+     * @return UnaryResult Transformed value and partial
+     */
+    UnaryResult apply( double value ) const
+    {
+        return UnaryResult{ std::log( value ), 1.0 / value };
+    }
+};
+
+
+/**
+ * @brief Natural logarithm function that takes an expression and creates a new expression with
+ * applied transformation.
+ *
+ * @tparam Expr Type of the expression
+ * @param expr Expression to apply natural logarithm to
+ * @return ScalarUnaryOp< Expr, LogarithmOp > Expression that represents the natural logarithm
+ */
+template< typename Expr >
+ScalarUnaryOp< Expr, LogarithmOp > log( const ScalarBase< Expr >& expr )
+{
+    return ScalarUnaryOp< Expr, LogarithmOp >(
+        static_cast< const Expr& >( expr ), LogarithmOp{} );
+}
+
+/**
+ * @brief Unary operation taken by \ref ScalarUnaryOp object to define the expression for
+ * computing the natural logarithm of one plus the value of an expression.
+ */
+struct LogarithmOnePlusOp
+{
+    /**
+     * @brief Applies the transformation on the value of an expression and computes the partial
+     * derivative of the unary operation.
+     *
+     * @param value Value of the expression
+     * @return UnaryResult Transformed value and partial
+     */
+    UnaryResult apply( double value ) const
+    {
+        return UnaryResult{ std::log1p( value ), 1.0 / ( 1.0 + value ) };
+    }
+};
+
+
+/**
+ * @brief Natural logarithm of one plus value function that takes an expression and creates a
+ * new expression with applied transformation. It is accurate for values close to zero.
+ *
+ * @tparam Expr Type of the expression
+ * @param expr Expression to apply natural logarithm of one plus value to
+ * @return ScalarUnaryOp< Expr, LogarithmOnePlusOp > Expression that represents the natural
+ * logarithm of one plus value
+ */
+template< typename Expr >
+ScalarUnaryOp< Expr, LogarithmOnePlusOp > log1p( const ScalarBase< Expr >& expr )
+{
+    return ScalarUnaryOp< Expr, LogarithmOnePlusOp >(
+        static_cast< const Expr& >( expr ), LogarithmOnePlusOp{} );
+}
+
+/**
+ * @brief Unary operation taken by \ref ScalarUnaryOp object to define the expression for
+ * computing the error function of an expression.
+ */
+struct ErrorFunctionOp
+{
+    /**
+     * @brief Applies the transformation on the value of an expression and computes the partial
+     * derivative of the unary operation, which is 2 / sqrt( pi ) * exp( -value^2 ).
+     *
+     * @param value Value of the expression
+     * @return UnaryResult Transformed value and partial
+     */
+    UnaryResult apply( double value ) const
+    {
+        return UnaryResult{ std::erf( value ), 1.1283791670955126 * std::exp( -value * value ) };
+    }
+};
+
+
+/**
+ * @brief Error function that takes an expression and creates a new expression with applied
+ * transformation.
+ *
+ * @tparam Expr Type of the expression
+ * @param expr Expression to apply error function to
+ * @return ScalarUnaryOp< Expr, ErrorFunctionOp > Expression that represents the error function
+ */
+template< typename Expr >
+ScalarUnaryOp< Expr, ErrorFunctionOp > erf( const ScalarBase< Expr >& expr )
+{
+    return ScalarUnaryOp< Expr, ErrorFunctionOp >(
+        static_cast< const Expr& >( expr ), ErrorFunctionOp{} );
+}
+
+/**
+ * @brief Operand order of \ref UnaryPowerOp, which raises an expression to the power of a number
+ * or a number to the power of an expression.
+ *
+ */
+enum class PowerMode
+{
+    Normal, /** The expression is the base and the number the exponent */
+    Reverse /** The number is the base and the expression the exponent */
+};
+
+/**
+ * @brief Unary operation taken by \ref ScalarUnaryOp object to define the expression for raising
+ * an expression to the power of a floating point number, or a floating point number to the power
+ * of an expression. This depends on the PowerMode flag.
+ */
+template< PowerMode Flag >
+class UnaryPowerOp
+{
+
+public:
+    /**
+     * @brief Construct a new Unary Power Op object with the exponent, or the base for the reverse
+     * mode.
+     *
+     * @param scalar Exponent or base
+     */
+    explicit UnaryPowerOp( double scalar )
+        : scalar_{ scalar }
+    {
+    }
+
+    /**
+     * @brief Applies the transformation on the value of an expression and computes the partial
+     * derivative of the unary operation. The partial is computed from the value, except for a
+     * zero base.
+     *
+     * @param value Value of the expression
+     * @return UnaryResult Transformed value and partial
+     */
+    UnaryResult apply( double value ) const
+    {
+        if ( Flag == PowerMode::Reverse )
+        {
+            const double tmp = std::pow( scalar_, value );
+            return UnaryResult{ tmp, tmp * std::log( scalar_ ) };
+        }
+        const double tmp = std::pow( value, scalar_ );
+        if ( std::fabs( value ) <= 0.0 )
+        {
+            return UnaryResult{ tmp, scalar_ * std::pow( value, scalar_ - 1.0 ) };
+        }
+        return UnaryResult{ tmp, scalar_ * tmp / value };
+    }
+
+private:
+    /** Exponent, or base for the reverse mode */
+    double scalar_;
+};
+
+
+/**
+ * @brief Power function raising an expression to the power of a floating point number.
+ *
+ * @tparam Expr Type of the expression
+ * @param expr Base expression
+ * @param exponent Floating point exponent
+ * @return ScalarUnaryOp< Expr, UnaryPowerOp< PowerMode::Normal > > Expression that represents the
+ * power
+ */
+template< typename Expr >
+ScalarUnaryOp< Expr, UnaryPowerOp< PowerMode::Normal > > pow(
+    const ScalarBase< Expr >& expr, double exponent )
+{
+    return ScalarUnaryOp< Expr, UnaryPowerOp< PowerMode::Normal > >{
+        static_cast< const Expr& >( expr ), UnaryPowerOp< PowerMode::Normal >{ exponent }
+    };
+}
+
+/**
+ * @brief Power function raising a floating point number to the power of an expression.
+ *
+ * @tparam Expr Type of the expression
+ * @param base Floating point base, positive
+ * @param expr Exponent expression
+ * @return ScalarUnaryOp< Expr, UnaryPowerOp< PowerMode::Reverse > > Expression that represents
+ * the power
+ */
+template< typename Expr >
+ScalarUnaryOp< Expr, UnaryPowerOp< PowerMode::Reverse > > pow(
+    double base, const ScalarBase< Expr >& expr )
+{
+    return ScalarUnaryOp< Expr, UnaryPowerOp< PowerMode::Reverse > >{
+        static_cast< const Expr& >( expr ), UnaryPowerOp< PowerMode::Reverse >{ base }
+    };
+}
+
+namespace detail
+{
+
+    /**
+     * @brief Compile-time exponentiation by squaring with a non-negative integer exponent.
+     *
+     * @tparam N Exponent
+     */
+    template< int N >
+    struct IntegerPower
+    {
+        /**
+         * @brief Raises a number to the power of N.
+         *
+         * @param value Base
+         * @return double Power
+         */
+        static double apply( double value )
+        {
+            const double tmp = IntegerPower< N / 2 >::apply( value );
+            return N % 2 == 0 ? tmp * tmp : tmp * tmp * value;
+        }
+    };
+
+    /**
+     * @brief Exponentiation by squaring, end of recursion for the exponent one.
+     *
+     */
+    template<>
+    struct IntegerPower< 1 >
+    {
+        /**
+         * @brief Raises a number to the power of one.
+         *
+         * @param value Base
+         * @return double The base itself
+         */
+        static double apply( double value )
+        {
+            return value;
+        }
+    };
+
+    /**
+     * @brief Exponentiation by squaring, exponent zero.
+     *
+     */
+    template<>
+    struct IntegerPower< 0 >
+    {
+        /**
+         * @brief Raises a number to the power of zero.
+         *
+         * @return double One, also for a zero base
+         */
+        static double apply( double )
+        {
+            return 1.0;
+        }
+    };
+
+} // detail
+
+/**
+ * @brief Unary operation taken by \ref ScalarUnaryOp object to define the expression for raising
+ * an expression to a compile-time integer power.
+ *
+ * @tparam N Exponent, which may be zero or negative
+ */
+template< int N >
+struct IntegerPowerOp
+{
+    /**
+     * @brief Applies the transformation on the value of an expression and computes the partial
+     * derivative of the unary operation. The power with exponent N - 1, or 1 / value for a
+     * negative exponent, is computed once by squaring and shared by the value and the partial.
+     *
+     * @param value Value of the expression
+     * @return UnaryResult Transformed value and partial
+     */
+    UnaryResult apply( double value ) const
+    {
+        if ( N > 0 )
+        {
+            const double tmp = detail::IntegerPower< ( N > 0 ? N - 1 : 0 ) >::apply( value );
+            return UnaryResult{ tmp * value, N * tmp };
+        }
+        if ( N < 0 )
+        {
+            const double inverse = 1.0 / value;
+            const double tmp = detail::IntegerPower< ( N < 0 ? -N : 0 ) >::apply( inverse );
+            return UnaryResult{ tmp, N * tmp * inverse };
+        }
+        return UnaryResult{ 1.0, 0.0 };
+    }
+};
+
+
+/**
+ * @brief Power function raising an expression to a compile-time integer power, as a single node
+ * instead of a chain of multiplications.
+ *
+ * @tparam N Exponent, which may be zero or negative
+ * @tparam Expr Type of the expression
+ * @param expr Base expression
+ * @return ScalarUnaryOp< Expr, IntegerPowerOp< N > > Expression that represents the power
+ */
+template< int N, typename Expr >
+ScalarUnaryOp< Expr, IntegerPowerOp< N > > pow( const ScalarBase< Expr >& expr )
+{
+    return ScalarUnaryOp< Expr, IntegerPowerOp< N > >(
+        static_cast< const Expr& >( expr ), IntegerPowerOp< N >{} );
+}
+
 } // metal
 
 #endif // METAL_UNARYMATHOP_H
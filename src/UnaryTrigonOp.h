@@ -9,31 +9,49 @@
 namespace metal
 {
 
-/**
- * @brief Unary operation taken by \ref ScalarUnaryOp object to define the expression for
- * computing the sine of an expression.
- */
-struct SineOp
+namespace detail
 {
+
     /**
-     * @brief Applies the transformation on the value of an expression.
+     * @brief Computes the sine and cosine of a number, with a single call to sincos where the
+     * C library provides it.
      *
-     * @param value Value of the expression
-     * @return double Transformed value
+     * @param value Angle
+     * @param sine Sine of the angle
+     * @param cosine Cosine of the angle
      */
-    double applyToValue( double value ) const
+    inline void sinCos( double value, double& sine, double& cosine )
     {
-        return std::sin( value );
+#if defined( __GLIBC__ ) && defined( _GNU_SOURCE )
+        ::sincos( value, &sine, &cosine );
+#else
+        sine = std::sin( value );
+        cosine = std::cos( value );
+#endif
     }
 
+} // detail
+
+
+/**
+ * @brief Unary operation taken by \ref ScalarUnaryOp object to define the expression for
+ * computing the sine of an expression.
+ */
+struct SineOp
+{
     /**
-     * @brief Computes the partial derivative of the unary operation.
+     * @brief Applies the transformation on the value of an expression and computes the partial
+     * derivative of the unary operation, see \ref detail::sinCos.
      *
-     * @return double Partial
+     * @param value Value of the expression
+     * @return UnaryResult Transformed value and partial
      */
-    double partial( double value ) const
+    UnaryResult apply( double value ) const
     {
-        return std::cos( value );
+        double sine;
+        double cosine;
+        detail::sinCos( value, sine, cosine );
+        return UnaryResult{ sine, cosine };
     }
 };
 
@@ -61,24 +79,18 @@ ScalarUnaryOp< Expr, SineOp > sin( const ScalarBase< Expr >& expr )
 struct CosineOp
 {
     /**
-     * @brief Applies the transformation on the value of an expression.
+     * @brief Applies the transformation on the value of an expression and computes the partial
+     * derivative of the unary operation, see \ref detail::sinCos.
      *
      * @param value Value of the expression
-     * @return double Transformed value
+     * @return UnaryResult Transformed value and partial
      */
-    double applyToValue( double value ) const
+    UnaryResult apply( double value ) const
     {
-        return std::cos( value );
-    }
-
-    /**
-     * @brief Computes the partial derivative of the unary operation.
-     *
-     * @return double Partial
-     */
-    double partial( double value ) const
-    {
-        return -std::sin( value );
+        double sine;
+        double cosine;
+        detail::sinCos( value, sine, cosine );
+        return UnaryResult{ cosine, -sine };
     }
 };
 
@@ -106,25 +118,16 @@ ScalarUnaryOp< Expr, CosineOp > cos( const ScalarBase< Expr >& expr )
 struct TangentOp
 {
     /**
-     * @brief Applies the transformation on the value of an expression.
+     * @brief Applies the transformation on the value of an expression and computes the partial
+     * derivative of the unary operation. The partial is computed from the value.
      *
      * @param value Value of the expression
-     * @return double Transformed value
-     */
-    double applyToValue( double value ) const
-    {
-        return std::tan( value );
-    }
-
-    /**
-     * @brief Computes the partial derivative of the unary operation.
-     *
-     * @return double Partial
+     * @return UnaryResult Transformed value and partial
      */
-    double partial( double value ) const
+    UnaryResult apply( double value ) const
     {
-        const double tmp = std::cos( value );
-        return 1.0 / ( tmp * tmp );
+        const double tmp = std::tan( value );
+        return UnaryResult{ tmp, 1.0 + tmp * tmp };
     }
 };
 
@@ -151,24 +154,16 @@ ScalarUnaryOp< Expr, TangentOp > tan( const ScalarBase< Expr >& expr )
 struct SineHyperOp
 {
     /**
-     * @brief Applies the transformation on the value of an expression.
+     * @brief Applies the transformation on the value of an expression and computes the partial
+     * derivative of the unary operation. The hyperbolic sine and cosine are
+     * computed next to each other.
      *
      * @param value Value of the expression
-     * @return double Transformed value
-     */
-    double applyToValue( double value ) const
-    {
-        return std::sinh( value );
-    }
-
-    /**
-     * @brief Computes the partial derivative of the unary operation.
-     *
-     * @return double Partial
+     * @return UnaryResult Transformed value and partial
      */
-    double partial( double value ) const
+    UnaryResult apply( double value ) const
     {
-        return std::cosh( value );
+        return UnaryResult{ std::sinh( value ), std::cosh( value ) };
     }
 };
 
@@ -196,24 +191,16 @@ ScalarUnaryOp< Expr, SineHyperOp > sinh( const ScalarBase< Expr >& expr )
 struct CosineHyperOp
 {
     /**
-     * @brief Applies the transformation on the value of an expression.
+     * @brief Applies the transformation on the value of an expression and computes the partial
+     * derivative of the unary operation. The hyperbolic sine and cosine are
+     * computed next to each other.
      *
      * @param value Value of the expression
-     * @return double Transformed value
+     * @return UnaryResult Transformed value and partial
      */
-    double applyToValue( double value ) const
+    UnaryResult apply( double value ) const
     {
-        return std::cosh( value );
-    }
-
-    /**
-     * @brief Computes the partial derivative of the unary operation.
-     *
-     * @return double Partial
-     */
-    double partial( double value ) const
-    {
-        return std::sinh( value );
+        return UnaryResult{ std::cosh( value ), std::sinh( value ) };
     }
 };
 
@@ -242,25 +229,16 @@ ScalarUnaryOp< Expr, CosineHyperOp > cosh( const ScalarBase< Expr >& expr )
 struct TangentHyperOp
 {
     /**
-     * @brief Applies the transformation on the value of an expression.
+     * @brief Applies the transformation on the value of an expression and computes the partial
+     * derivative of the unary operation. The partial is computed from the value.
      *
      * @param value Value of the expression
-     * @return double Transformed value
-     */
-    double applyToValue( double value ) const
-    {
-        return std::tanh( value );
-    }
-
-    /**
-     * @brief Computes the partial derivative of the unary operation.
-     *
-     * @return double Partial
+     * @return UnaryResult Transformed value and partial
      */
-    double partial( double value ) const
+    UnaryResult apply( double value ) const
     {
         const double tmp = std::tanh( value );
-        return 1.0 - tmp * tmp;
+        return UnaryResult{ tmp, 1.0 - tmp * tmp };
     }
 };
 
@@ -0,0 +1,562 @@
+#ifndef METAL_VALUESCALAR_H
+#define METAL_VALUESCALAR_H
+
+
+#include "src/BinaryAdditionOp.h"
+#include "src/BinaryDivisionOp.h"
+#include "src/BinaryMathOp.h"
+#include "src/BinaryMultiplyOp.h"
+#include "src/BinarySubtractionOp.h"
+#include "src/BinaryTrigonOp.h"
+#include "src/UnaryAdditionOp.h"
+#include "src/UnaryDivisionOp.h"
+#include "src/UnaryInverseTrigonOp.h"
+#include "src/UnaryMathOp.h"
+#include "src/UnaryMultiplyOp.h"
+#include "src/UnaryNegateOp.h"
+#include "src/UnarySubtractionOp.h"
+#include "src/UnaryTrigonOp.h"
+
+
+namespace metal
+{
+
+/**
+ * @brief Scalar type with the interface of \ref Scalar that computes values only.
+ *
+ * It is not part of the ET design architecture: every operation is evaluated immediately by the
+ * operation of the expressions on plain doubles and returns a new value scalar, so both policies
+ * give identical values and new operations are implemented once. Constructors that would create or
+ * take parameters ignore them, and the scalar reports no partial derivatives.
+ *
+ * @see BasicScalar
+ */
+class ValueScalar
+{
+
+public:
+    /** Alias for type of partial derivative vector, only used by the ignored constructor input */
+    using Partial = EigenRowVector;
+
+
+    /**
+     * @brief Construct a new Value Scalar object.
+     *
+     * Default for the value is zero.
+     *
+     * @param value Value of the scalar object
+     */
+    explicit ValueScalar( double value = 0.0 )
+        : value_{ value }
+    {
+    }
+
+    /**
+     * @brief Construct a new Value Scalar object, ignoring the parameter and its partials.
+     *
+     * @param value Value of the scalar object
+     */
+    ValueScalar( double value, const ParameterPtr&, const Partial& )
+        : value_{ value }
+    {
+    }
+
+    /**
+     * @brief Construct a new Value Scalar object, without creating a parameter.
+     *
+     * @param value Value of the scalar object
+     */
+    ValueScalar( double value, const std::string& )
+        : value_{ value }
+    {
+    }
+
+    /**
+     * @brief Returns the value of the scalar.
+     *
+     * @return double Value
+     */
+    double value() const
+    {
+        return value_;
+    }
+
+    /**
+     * @brief Returns the dimension of the partial derivative vector, always zero.
+     *
+     * @return size_t Dimension
+     */
+    size_t dim() const
+    {
+        return 0;
+    }
+
+    /**
+     * @brief Returns the number of parameters, always zero.
+     *
+     * @return size_t Number of parameters
+     */
+    size_t size() const
+    {
+        return 0;
+    }
+
+    /**
+     * @brief Returns the parameters, always empty.
+     *
+     * @return const ParameterPtrVector& Empty vector of parameters
+     */
+    const ParameterPtrVector& parameters() const
+    {
+        static const ParameterPtrVector empty{};
+        return empty;
+    }
+
+    /**
+     * @brief Checks for existance of a parameter, always false.
+     *
+     * @return false No parameters
+     */
+    bool contains( const ParameterPtr& ) const
+    {
+        return false;
+    }
+
+    /**
+     * @brief Partial derivatives are not available.
+     *
+     * @throws std::runtime_error
+     *
+     * @param p Parameter to get partial derivative with respect to
+     * @return EigenRowVector Never returns
+     */
+    EigenRowVector at( const ParameterPtr& p ) const
+    {
+        throw std::runtime_error( "Error! Parameter not present in partials: '"
+            + ( p ? p->name() : "NULLPTR" ) + "'" );
+    }
+
+    /**
+     * @brief In-place addition operator.
+     *
+     * @param other Value to add
+     * @return ValueScalar& Reference to modified object
+     */
+    ValueScalar& operator+=( const ValueScalar& other )
+    {
+        value_ += other.value_;
+        return *this;
+    }
+
+    /**
+     * @brief In-place subtraction operator.
+     *
+     * @param other Value to subtract
+     * @return ValueScalar& Reference to modified object
+     */
+    ValueScalar& operator-=( const ValueScalar& other )
+    {
+        value_ -= other.value_;
+        return *this;
+    }
+
+    /**
+     * @brief In-place multiplication operator.
+     *
+     * @param other Value to multiply with
+     * @return ValueScalar& Reference to modified object
+     */
+    ValueScalar& operator*=( const ValueScalar& other )
+    {
+        value_ *= other.value_;
+        return *this;
+    }
+
+    /**
+     * @brief In-place division operator.
+     *
+     * @param other Value to divide with
+     * @return ValueScalar& Reference to modified object
+     */
+    ValueScalar& operator/=( const ValueScalar& other )
+    {
+        value_ /= other.value_;
+        return *this;
+    }
+
+    /**
+     * @brief In-place addition operator with a number.
+     *
+     * @param other Floating point value to add
+     * @return ValueScalar& Reference to modified object
+     */
+    ValueScalar& operator+=( double other )
+    {
+        value_ += other;
+        return *this;
+    }
+
+    /**
+     * @brief In-place subtraction operator with a number.
+     *
+     * @param other Floating point value to subtract
+     * @return ValueScalar& Reference to modified object
+     */
+    ValueScalar& operator-=( double other )
+    {
+        value_ -= other;
+        return *this;
+    }
+
+    /**
+     * @brief In-place multiplication operator with a number.
+     *
+     * @param other Floating point value to multiply with
+     * @return ValueScalar& Reference to modified object
+     */
+    ValueScalar& operator*=( double other )
+    {
+        value_ *= other;
+        return *this;
+    }
+
+    /**
+     * @brief In-place division operator with a number.
+     *
+     * @param other Floating point value to divide with
+     * @return ValueScalar& Reference to modified object
+     */
+    ValueScalar& operator/=( double other )
+    {
+        value_ /= other;
+        return *this;
+    }
+
+    /**
+     * @brief Adds another scalar multiplied by a number to this.
+     *
+     * @param other Scalar to add to this
+     * @param scalar Multiplier
+     */
+    void multAndAdd( const ValueScalar& other, double scalar )
+    {
+        value_ += scalar * other.value_;
+    }
+
+private:
+    /** Physical value of the scalar */
+    double value_;
+};
+
+
+/**
+ * @brief Output stream function for value scalars, printing the value only.
+ *
+ * @param os Output stream to print to
+ * @param x Scalar to print
+ * @return std::ostream& Modified output stream
+ */
+inline std::ostream& operator<<( std::ostream& os, const ValueScalar& x )
+{
+    return os << x.value();
+}
+
+
+namespace detail
+{
+
+    /**
+     * @brief Applies a unary operation of the expressions on the value of a value scalar, so
+     * both policies share one implementation of every operation.
+     *
+     * @tparam Op Type of the operation
+     * @param op Operation
+     * @param x Operand
+     * @return ValueScalar Result of the operation
+     */
+    template< typename Op >
+    ValueScalar applyValue( const Op& op, const ValueScalar& x )
+    {
+        return ValueScalar{ applyUnary( op, x.value() ).value };
+    }
+
+    /**
+     * @brief Applies a binary operation of the expressions on the values of two value scalars,
+     * so both policies share one implementation of every operation.
+     *
+     * @tparam Op Type of the operation
+     * @param op Operation
+     * @param x LHS of the operation
+     * @param y RHS of the operation
+     * @return ValueScalar Result of the operation
+     */
+    template< typename Op >
+    ValueScalar applyValue( const Op& op, const ValueScalar& x, const ValueScalar& y )
+    {
+        return ValueScalar{ applyBinary( op, x.value(), y.value() ).value };
+    }
+
+} // detail
+
+
+/** Unary minus */
+inline ValueScalar operator-( const ValueScalar& x )
+{
+    return detail::applyValue( UnaryNegateOp{}, x );
+}
+
+/** Unary plus */
+inline ValueScalar operator+( const ValueScalar& x )
+{
+    return x;
+}
+
+/** Addition */
+inline ValueScalar operator+( const ValueScalar& x, const ValueScalar& y )
+{
+    return detail::applyValue( BinaryAdditionOp{}, x, y );
+}
+
+/** Addition with a number */
+inline ValueScalar operator+( const ValueScalar& x, double y )
+{
+    return detail::applyValue( UnaryAdditionOp{ y }, x );
+}
+
+/** Addition to a number */
+inline ValueScalar operator+( double x, const ValueScalar& y )
+{
+    return detail::applyValue( UnaryAdditionOp{ x }, y );
+}
+
+/** Subtraction */
+inline ValueScalar operator-( const ValueScalar& x, const ValueScalar& y )
+{
+    return detail::applyValue( BinarySubtractionOp{}, x, y );
+}
+
+/** Subtraction of a number */
+inline ValueScalar operator-( const ValueScalar& x, double y )
+{
+    return detail::applyValue( UnarySubtractionOp< SubtractMode::Normal >{ y }, x );
+}
+
+/** Subtraction from a number */
+inline ValueScalar operator-( double x, const ValueScalar& y )
+{
+    return detail::applyValue( UnarySubtractionOp< SubtractMode::Reverse >{ x }, y );
+}
+
+/** Multiplication */
+inline ValueScalar operator*( const ValueScalar& x, const ValueScalar& y )
+{
+    return detail::applyValue( BinaryMultiplyOp{}, x, y );
+}
+
+/** Multiplication with a number */
+inline ValueScalar operator*( const ValueScalar& x, double y )
+{
+    return detail::applyValue( UnaryMultiplyOp{ y }, x );
+}
+
+/** Multiplication of a number */
+inline ValueScalar operator*( double x, const ValueScalar& y )
+{
+    return detail::applyValue( UnaryMultiplyOp{ x }, y );
+}
+
+/** Division */
+inline ValueScalar operator/( const ValueScalar& x, const ValueScalar& y )
+{
+    return detail::applyValue( BinaryDivisionOp{}, x, y );
+}
+
+/** Division by a number */
+inline ValueScalar operator/( const ValueScalar& x, double y )
+{
+    return detail::applyValue( UnaryDivisionOp< DivisionMode::Normal >{ y }, x );
+}
+
+/** Division of a number */
+inline ValueScalar operator/( double x, const ValueScalar& y )
+{
+    return detail::applyValue( UnaryDivisionOp< DivisionMode::Reverse >{ x }, y );
+}
+
+/** Square */
+inline ValueScalar sqr( const ValueScalar& x )
+{
+    return detail::applyValue( SquareOp{}, x );
+}
+
+/** Cube */
+inline ValueScalar cube( const ValueScalar& x )
+{
+    return detail::applyValue( CubeOp{}, x );
+}
+
+/** Square root */
+inline ValueScalar sqrt( const ValueScalar& x )
+{
+    return detail::applyValue( SquareRootOp{}, x );
+}
+
+/** Cube root */
+inline ValueScalar cbrt( const ValueScalar& x )
+{
+    return detail::applyValue( CubeRootOp{}, x );
+}
+
+/** Exponential */
+inline ValueScalar exp( const ValueScalar& x )
+{
+    return detail::applyValue( ExponentialOp{}, x );
+}
+
+/** Exponential minus one */
+inline ValueScalar expm1( const ValueScalar& x )
+{
+    return detail::applyValue( ExponentialMinusOneOp{}, x );
+}
+
+/** Natural logarithm */
+inline ValueScalar log( const ValueScalar& x )
+{
+    return detail::applyValue( LogarithmOp{}, x );
+}
+
+/** Natural logarithm of one plus value */
+inline ValueScalar log1p( const ValueScalar& x )
+{
+    return detail::applyValue( LogarithmOnePlusOp{}, x );
+}
+
+/** Error function */
+inline ValueScalar erf( const ValueScalar& x )
+{
+    return detail::applyValue( ErrorFunctionOp{}, x );
+}
+
+/** Power */
+inline ValueScalar pow( const ValueScalar& x, const ValueScalar& y )
+{
+    return detail::applyValue( BinaryPowerOp{}, x, y );
+}
+
+/** Power with a number as exponent */
+inline ValueScalar pow( const ValueScalar& x, double y )
+{
+    return detail::applyValue( UnaryPowerOp< PowerMode::Normal >{ y }, x );
+}
+
+/** Power with a number as base */
+inline ValueScalar pow( double x, const ValueScalar& y )
+{
+    return detail::applyValue( UnaryPowerOp< PowerMode::Reverse >{ x }, y );
+}
+
+/** Power with a compile-time integer exponent */
+template< int N >
+ValueScalar pow( const ValueScalar& x )
+{
+    return detail::applyValue( IntegerPowerOp< N >{}, x );
+}
+
+/** Hypotenuse */
+inline ValueScalar hypot( const ValueScalar& x, const ValueScalar& y )
+{
+    return detail::applyValue( HypotOp{}, x, y );
+}
+
+/** Sine */
+inline ValueScalar sin( const ValueScalar& x )
+{
+    return detail::applyValue( SineOp{}, x );
+}
+
+/** Cosine */
+inline ValueScalar cos( const ValueScalar& x )
+{
+    return detail::applyValue( CosineOp{}, x );
+}
+
+/** Tangent */
+inline ValueScalar tan( const ValueScalar& x )
+{
+    return detail::applyValue( TangentOp{}, x );
+}
+
+/** Hyperbolic sine */
+inline ValueScalar sinh( const ValueScalar& x )
+{
+    return detail::applyValue( SineHyperOp{}, x );
+}
+
+/** Hyperbolic cosine */
+inline ValueScalar cosh( const ValueScalar& x )
+{
+    return detail::applyValue( CosineHyperOp{}, x );
+}
+
+/** Hyperbolic tangent */
+inline ValueScalar tanh( const ValueScalar& x )
+{
+    return detail::applyValue( TangentHyperOp{}, x );
+}
+
+/** Inverse sine */
+inline ValueScalar asin( const ValueScalar& x )
+{
+    return detail::applyValue( InverseSineOp{}, x );
+}
+
+/** Inverse cosine */
+inline ValueScalar acos( const ValueScalar& x )
+{
+    return detail::applyValue( InverseCosineOp{}, x );
+}
+
+/** Inverse tangent */
+inline ValueScalar atan( const ValueScalar& x )
+{
+    return detail::applyValue( InverseTangentOp{}, x );
+}
+
+/** Inverse hyperbolic sine */
+inline ValueScalar asinh( const ValueScalar& x )
+{
+    return detail::applyValue( InverseSineHyperOp{}, x );
+}
+
+/** Inverse hyperbolic cosine */
+inline ValueScalar acosh( const ValueScalar& x )
+{
+    return detail::applyValue( InverseCosineHyperOp{}, x );
+}
+
+/** Inverse hyperbolic tangent */
+inline ValueScalar atanh( const ValueScalar& x )
+{
+    return detail::applyValue( InverseTangentHyperOp{}, x );
+}
+
+/** Two-argument arc tangent */
+inline ValueScalar atan2( const ValueScalar& y, const ValueScalar& x )
+{
+    return detail::applyValue( Atan2Op{}, y, x );
+}
+
+/**
+ * @brief Returns the value of a value scalar, see \ref valueOf.
+ *
+ * @param x Scalar
+ * @return double Value of the scalar
+ */
+inline double valueOf( const ValueScalar& x )
+{
+    return x.value();
+}
+
+} // metal
+
+#endif // METAL_VALUESCALAR_H
@@ -1,4 +1,6 @@
 #include "src/Core.h"
+#include "src/LinearAlgebra.h"
+#include "src/Matrix.h"
 #include <chrono>
 #include <iomanip>
 
@@ -45,6 +47,16 @@ void measure( const Func& func, bool verbose = false )
 }
 
 
+template< typename Policy >
+metal::BasicScalar< Policy > model( double x0 )
+{
+    using T = metal::BasicScalar< Policy >;
+    const T x{ x0, "x" };
+    const T two{ 2.0 };
+    return T{ sin( x * 2.0 ) * sqrt( x ) - atan2( x, two ) / ( 1.0 + x * x ) };
+}
+
+
 int main()
 {
     const metal::Scalar a{ 3.0, "a" };
@@ -65,5 +77,288 @@ int main()
     measure( f1, true );
     measure( f2, true );
 
+    // Wide expressions with many parameters, comparing the evaluation strategies
+    std::vector< metal::Scalar > wide( 4 );
+    for ( int i = 0; i < 64; i++ )
+    {
+        const metal::Scalar p{ 1.0 + 0.01 * i, "p" + std::to_string( i ) };
+        wide[i % wide.size()] = metal::Scalar{ wide[i % wide.size()] + p };
+    }
+
+    const auto f3 = [&]( metal::Evaluation mode ) -> metal::Scalar
+    {
+        return metal::Scalar{ sin( wide[0] ) * wide[1] - wide[2] / wide[3] + a * wide[0], mode };
+    };
+
+    std::cout << "Wide expression, accumulate: ";
+    measure( [&]() { return f3( metal::Evaluation::Accumulate ); } );
+    std::cout << "Wide expression, scatter: ";
+    measure( [&]() { return f3( metal::Evaluation::Scatter ); } );
+
+    // Wide sums of differently parameterized terms, dominated by the parameter union
+    std::vector< metal::Scalar > terms;
+    for ( int i = 0; i < 16; i++ )
+    {
+        terms.emplace_back( 1.0 + i, "t" + std::to_string( i ) );
+    }
+
+    std::cout << "Wide sum construction: ";
+    measure( [&]() {
+        return metal::Scalar{ terms[0] + terms[1] + terms[2] + terms[3] + terms[4] + terms[5]
+            + terms[6] + terms[7] + terms[8] + terms[9] + terms[10] + terms[11] + terms[12]
+            + terms[13] + terms[14] + terms[15] };
+    } );
+
+    std::cout << "Wide sum dimension: ";
+    measure( [&]() {
+        return ( terms[0] + terms[1] + terms[2] + terms[3] + terms[4] + terms[5] + terms[6]
+            + terms[7] + terms[8] + terms[9] + terms[10] + terms[11] + terms[12] + terms[13]
+            + terms[14] + terms[15] )
+            .dim();
+    } );
+
+    std::cout << "Wide sum value only: ";
+    measure( [&]() {
+        return metal::valueOf( terms[0] + terms[1] + terms[2] + terms[3] + terms[4] + terms[5]
+            + terms[6] + terms[7] + terms[8] + terms[9] + terms[10] + terms[11] + terms[12]
+            + terms[13] + terms[14] + terms[15] );
+    } );
+
+    // Expressions of a few elements of a large bias vector, evaluated densely or sparsely
+    const int biasDim = 2000;
+    const auto bias = std::make_shared< metal::NamedParameter >( biasDim, "bias" );
+    std::vector< metal::Scalar > biases;
+    for ( int i = 0; i < 4; i++ )
+    {
+        biases.emplace_back( 1.0 + i, bias, metal::EigenRowVector::Unit( biasDim, 100 * i ) );
+    }
+
+    const auto f4 = [&]( metal::Evaluation mode ) -> metal::Scalar
+    {
+        return metal::Scalar{ sin( biases[0] ) * biases[1] - biases[2] / biases[3] + a, mode };
+    };
+
+    std::cout << "Bias expression, dense accumulate: ";
+    measure( [&]() { return f4( metal::Evaluation::Accumulate ); } );
+    std::cout << "Bias expression, sparse scatter: ";
+    measure( [&]() { return f4( metal::Evaluation::Scatter ); } );
+
+    // Same model code with and without derivatives
+    std::cout << "Model with derivatives: ";
+    measure( []() { return model< metal::WithDerivatives >( 1.5 ); } );
+    std::cout << "Model without derivatives: ";
+    measure( []() { return model< metal::NoDerivatives >( 1.5 ); } );
+
+    // Exponential atmosphere drag with native math operations
+    const metal::Scalar h{ 400.0, "h" };
+    const metal::Scalar v{ 7.6, "v" };
+    std::cout << "Exponential atmosphere drag: ";
+    measure( [&]() {
+        return metal::Scalar{ 1.225e9 * exp( -h / 8.5 ) * pow( v, 2.0 ) * 0.5
+            + log1p( hypot( h, v ) ) };
+    } );
+
+    // Sum of eight terms, nested binary nodes against one flat node by chaining or at once
+    std::cout << "Sum of 8 terms, nested: ";
+    measure( [&]() {
+        return metal::Scalar{ a + ( b + ( c + ( d + ( a * 2.0 + ( b * 3.0 + ( c * 4.0
+            + d * 5.0 ) ) ) ) ) ) };
+    } );
+    std::cout << "Sum of 8 terms, flat: ";
+    measure( [&]() {
+        return metal::Scalar{ a + b + c + d + a * 2.0 + b * 3.0 + c * 4.0 + d * 5.0 };
+    } );
+    std::cout << "Sum of 8 terms, variadic: ";
+    measure( [&]() {
+        return metal::Scalar{ sum( a, b, c, d, a * 2.0, b * 3.0, c * 4.0, d * 5.0 ) };
+    } );
+
+    // Runge-Kutta combination of 13 stages sharing one layout
+    std::vector< metal::Scalar > stages;
+    for ( int i = 0; i < 13; i++ )
+    {
+        stages.emplace_back( metal::Scalar{ ( a + 0.1 * i ) * b + c * sin( d ) } );
+        stages.back() = metal::Scalar{ stages.back() * ( i % 2 ? a : c ) };
+    }
+    std::vector< double > stageWeights( stages.size(), 1.0 / 13.0 );
+    std::cout << "Stage combination, summed one by one: ";
+    measure( [&]() {
+        metal::Scalar sum{ stageWeights[0] * stages[0] };
+        for ( size_t i = 1; i < stages.size(); i++ )
+        {
+            sum = metal::Scalar{ sum + stageWeights[i] * stages[i] };
+        }
+        return sum;
+    } );
+    std::cout << "Stage combination, linear combination: ";
+    measure( [&]() { return metal::linearCombination( stageWeights, stages ); } );
+
+    // Filter-like update loop, new scalar per step against in-place assignment
+    std::cout << "Update loop, new scalar per step: ";
+    metal::Scalar state1 = a;
+    measure( [&]() {
+        state1 = metal::Scalar{ 0.9 * state1 + 0.1 * ( b * c - d ) };
+        return state1;
+    } );
+    std::cout << "Update loop, in-place assignment: ";
+    metal::Scalar state2 = a;
+    measure( [&]() {
+        state2 = 0.9 * state2 + 0.1 * ( b * c - d );
+        return state2.value();
+    } );
+
+    // Same update with the layout work recorded once per call site
+    std::cout << "Update loop, evaluation plan: ";
+    metal::Scalar state3 = a;
+    metal::EvaluationPlan plan;
+    measure( [&]() {
+        state3 = metal::Scalar{ 0.9 * state3 + 0.1 * ( b * c - d ), plan };
+        return state3.value();
+    } );
+
+    // Replaying a plan skips all layout work of plain evaluation
+    const metal::Scalar ab{ a * b + 1.0 };
+    const metal::Scalar bc{ b * c };
+    const metal::Scalar ac{ a + c };
+    std::cout << "Mixed expression, plain: ";
+    measure( [&]() { return metal::Scalar{ sin( a ) * ab - bc / ac + b * c }.value(); } );
+    std::cout << "Mixed expression, evaluation plan: ";
+    metal::EvaluationPlan mixedPlan;
+    measure(
+        [&]() { return metal::Scalar{ sin( a ) * ab - bc / ac + b * c, mixedPlan }.value(); } );
+
+    // Scaling by constant coefficients stored as scalars, in place against through expressions
+    const metal::Scalar gain{ 1.25 };
+    const metal::Scalar loss{ 0.8 };
+    metal::Scalar scaled = a * b + c;
+    std::cout << "In-place scaling by constant scalars: ";
+    measure( [&]() {
+        scaled *= gain;
+        scaled *= loss;
+        return scaled.value();
+    } );
+    std::cout << "Scaling by constant scalars through expressions: ";
+    measure( [&]() {
+        scaled = metal::Scalar{ scaled * gain };
+        scaled = metal::Scalar{ scaled * loss };
+        return scaled.value();
+    } );
+
+    // Inverse cube of the distance, chained multiplications against one integer power node
+    const metal::Scalar r{ 7000.0, "r" };
+    std::cout << "Inverse cube, chained: ";
+    measure( [&]() { return metal::Scalar{ 1.0 / ( r * r * r ) }; } );
+    std::cout << "Inverse cube, integer power: ";
+    measure( [&]() { return metal::Scalar{ metal::pow< -3 >( r ) }; } );
+
+    // Cost function of many parameters, forward mode against reverse mode
+    const int costDim = 500;
+    const auto forwardCost = [&]() {
+        std::vector< metal::Scalar > x;
+        for ( int i = 0; i < costDim; i++ )
+        {
+            x.emplace_back( 0.001 * i, "x" + std::to_string( i ) );
+        }
+        metal::Scalar cost = metal::Scalar{ sqr( x[0] ) };
+        for ( int i = 1; i < costDim; i++ )
+        {
+            cost = metal::Scalar{ cost + sqr( x[i] - 0.5 ) * x[i - 1] + sin( x[i] ) };
+        }
+        return cost;
+    };
+    const auto reverseCost = [&]() {
+        metal::Tape::local().clear();
+        std::vector< metal::TapeScalar > x;
+        for ( int i = 0; i < costDim; i++ )
+        {
+            x.emplace_back( 0.001 * i, "x" );
+        }
+        metal::TapeScalar cost = sqr( x[0] );
+        for ( int i = 1; i < costDim; i++ )
+        {
+            cost = metal::TapeScalar{ cost + sqr( x[i] - 0.5 ) * x[i - 1] + sin( x[i] ) };
+        }
+        return cost.gradient();
+    };
+
+    std::cout << "Cost function of 500 parameters, forward mode: ";
+    measure( forwardCost );
+    std::cout << "Cost function of 500 parameters, reverse mode: ";
+    measure( reverseCost );
+
+    // 6-state kernels with dynamic and fixed dimension partials
+    const Eigen::Matrix< double, 6, 1 > state = Eigen::Matrix< double, 6, 1 >::LinSpaced( 1.0, 6.0 );
+    const Eigen::Matrix< double, 6, 6 > stm = Eigen::Matrix< double, 6, 6 >::Random();
+    const metal::Vector6 x6 = metal::create< metal::NamedParameter >( state, true, "x" );
+    const metal::VectorNT< 6, 6 > xn6 = metal::createN< metal::NamedParameter >( state, "x" );
+    const metal::Matrix6 m6 = stm.cast< metal::Scalar >();
+    const metal::MatrixNT< 6, 6, 6 > mn6 = stm.cast< metal::ScalarN< 6 > >();
+
+    std::cout << "Matrix6 * Vector6, Scalar: ";
+    measure( [&]() { return metal::Vector6{ m6 * x6 }; } );
+    std::cout << "Matrix6 * Vector6, ScalarN< 6 >: ";
+    measure( [&]() { return metal::VectorNT< 6, 6 >{ mn6 * xn6 }; } );
+
+    // Elementwise step of a 6-state vector, all elements sharing the layout of the state
+    std::cout << "State step, Scalar: ";
+    measure( [&]() {
+        metal::Vector6 next;
+        for ( int i = 0; i < 6; i++ )
+        {
+            next[i] = metal::Scalar{ x6[i] + 0.1 * sin( x6[( i + 1 ) % 6] ) * x6[i] };
+        }
+        return next;
+    } );
+    std::cout << "State step, ScalarN< 6 >: ";
+    measure( [&]() {
+        metal::VectorNT< 6, 6 > next;
+        for ( int i = 0; i < 6; i++ )
+        {
+            next[i] = metal::ScalarN< 6 >{ xn6[i] + 0.1 * sin( xn6[( i + 1 ) % 6] ) * xn6[i] };
+        }
+        return next;
+    } );
+
+    // Weighted sum of 6x6 matrices with partials, matrices of scalars against jet matrices
+    const metal::JetMatrix6 jm = metal::createJet< metal::NamedParameter >( stm, "m" );
+    const metal::JetMatrix6 jn = metal::createJet< metal::NamedParameter >(
+        Eigen::Matrix< double, 6, 6 >{ stm.transpose() }, "n" );
+    const metal::Matrix6 sm = jm.toMatrix();
+    const metal::Matrix6 sn = jn.toMatrix();
+
+    std::cout << "Matrix6 weighted sum, Scalar: ";
+    measure( [&]() { return metal::Matrix6{ sm + 0.5 * sn }; } );
+    std::cout << "Matrix6 weighted sum, JetMatrix6: ";
+    measure( [&]() { return jm + 0.5 * jn; } );
+
+    // Product of 6x6 matrices with partials, elementwise against the product rule on jet matrices
+    std::cout << "Matrix6 product, Scalar: ";
+    measure( [&]() { return metal::Matrix6{ sm * sn }; } );
+    std::cout << "Matrix6 product, JetMatrix6: ";
+    measure( [&]() { return jm * jn; } );
+
+    // Linear solve of a 6x6 system with partials, one factorization for value and partials
+    const metal::JetVector6 jx = metal::createJet< metal::NamedParameter >( state, "x" );
+    std::cout << "Matrix6 solve, JetMatrix6: ";
+    measure( [&]() { return metal::solve( jm, jx ); } );
+
+    // Inverse and log-determinant of a 40x40 covariance with partials w.r.t. all its elements
+    const Eigen::MatrixXd root = Eigen::MatrixXd::Random( 40, 40 );
+    const Eigen::MatrixXd covariance
+        = root * root.transpose() + Eigen::MatrixXd::Identity( 40, 40 );
+    const metal::JetMatrixX jp = metal::createJet< metal::NamedParameter >( covariance, "P" );
+    std::cout << "Covariance40 inverse, JetMatrixX: ";
+    measure( [&]() { return metal::inverse( jp ); } );
+    std::cout << "Covariance40 log-determinant, JetMatrixX: ";
+    measure( [&]() { return metal::logDeterminant( jp ); } );
+
+    // Decompositions of a 6x6 matrix with partials
+    const Eigen::Matrix< double, 6, 6 > identity6 = Eigen::Matrix< double, 6, 6 >::Identity();
+    const metal::JetMatrix6 jc = jm.transpose() * jm + metal::JetMatrix6{ identity6 };
+    std::cout << "Matrix6 Cholesky, JetMatrix6: ";
+    measure( [&]() { return metal::cholesky( jc ); } );
+    std::cout << "Matrix6 QR, JetMatrix6: ";
+    measure( [&]() { return metal::qr( jm ); } );
+
     return 0;
 }
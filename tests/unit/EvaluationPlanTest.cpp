@@ -0,0 +1,109 @@
+#include "TestSuite.h"
+
+
+using namespace metal;
+
+
+TEST_CASE( "Evaluation plans reuse the layout work of a call site", "[evaluation_plan]" )
+{
+    const Scalar a{ 1.0, "a" };
+    const Scalar b{ 2.0, "b" };
+    const Scalar c{ 3.0, "c" };
+    const Scalar ab = a * b;
+    const Scalar bc = b - c;
+
+    SECTION( "Replayed evaluations agree with the usual evaluation" )
+    {
+        EvaluationPlan plan;
+        Scalar x = ab;
+        for ( int i = 0; i < 5; i++ )
+        {
+            const Scalar y{ 0.5 * x + sin( bc ) * ab, plan };
+            const Scalar z{ 0.5 * x + sin( bc ) * ab };
+
+            REQUIRE( y.layout() == z.layout() );
+            REQUIRE( y.value() == z.value() );
+            REQUIRE( y.partial().toDense() == z.partial().toDense() );
+            x = y;
+        }
+
+        REQUIRE( plan.recorded() );
+        REQUIRE( plan.misses() == 2 );
+        REQUIRE( plan.hits() == 3 );
+        REQUIRE( plan.layout() == x.layout() );
+    }
+
+    SECTION( "Different leaf layouts record the plan again" )
+    {
+        EvaluationPlan plan;
+        const Scalar x{ ab + 2.0 * ab, plan };
+        const Scalar y{ ab + 2.0 * bc, plan };
+        const Scalar z{ ab + 2.0 * bc, plan };
+
+        REQUIRE( x.size() == 2 );
+        REQUIRE( y.size() == 3 );
+        REQUIRE( z.layout() == y.layout() );
+        REQUIRE( almostEqual( z.at( c )[0], -2.0 ) );
+        REQUIRE( plan.misses() == 2 );
+        REQUIRE( plan.hits() == 1 );
+    }
+
+    SECTION( "Different numbers of leaves record the plan again" )
+    {
+        EvaluationPlan plan;
+        ScalarAccumulator acc;
+        acc.add( ab ).add( bc );
+        const Scalar x{ acc, plan };
+        acc.add( bc );
+        const Scalar y{ acc, plan };
+        acc.clear();
+        acc.add( ab );
+        const Scalar z{ acc, plan };
+
+        REQUIRE( almostEqual( x.at( c )[0], -1.0 ) );
+        REQUIRE( almostEqual( y.at( c )[0], -2.0 ) );
+        REQUIRE( z.layout() == ab.layout() );
+        REQUIRE( plan.misses() == 3 );
+        REQUIRE( plan.hits() == 0 );
+    }
+
+    SECTION( "Expressions without partials" )
+    {
+        EvaluationPlan plan;
+        const Scalar d{ 4.0 };
+        for ( int i = 0; i < 2; i++ )
+        {
+            const Scalar x{ d * d + 1.0, plan };
+
+            REQUIRE_VALUE_EQUAL( x, 17.0 );
+            REQUIRE_PARTIALS_EMPTY( x );
+        }
+
+        REQUIRE( plan.layout() == nullptr );
+        REQUIRE( plan.hits() == 1 );
+
+        plan.clear();
+        REQUIRE( !plan.recorded() );
+    }
+
+    SECTION( "Sparse leaves" )
+    {
+        const int dim = 100;
+        const auto p = std::make_shared< NamedParameter >( dim, "p" );
+        EigenRowVector unit = EigenRowVector::Zero( dim );
+        unit[3] = 1.0;
+        const Scalar s{ 1.0, p, unit };
+        REQUIRE( s.partial().isSparse() );
+
+        EvaluationPlan plan;
+        for ( int i = 0; i < 2; i++ )
+        {
+            const Scalar x{ 3.0 * s + a, plan };
+
+            REQUIRE( x.partial().isSparse() );
+            REQUIRE( x.at( p )[3] == 3.0 );
+            REQUIRE( x.at( a )[0] == 1.0 );
+        }
+        REQUIRE( plan.hits() == 1 );
+    }
+}
@@ -0,0 +1,154 @@
+#include "TestSuite.h"
+#include "src/JetMatrix.h"
+
+
+using namespace metal;
+
+
+/**
+ * @brief Checks that a jet matrix has the values and partials of a matrix of scalars.
+ */
+template< int Rows, int Cols >
+bool sameAs( const JetMatrix< Rows, Cols >& jet, const MatrixT< Rows, Cols >& matrix )
+{
+    if ( jet.rows() != matrix.rows() || jet.cols() != matrix.cols() )
+    {
+        return false;
+    }
+    for ( Eigen::Index j = 0; j < jet.cols(); j++ )
+    {
+        for ( Eigen::Index i = 0; i < jet.rows(); i++ )
+        {
+            const Scalar x = jet( i, j );
+            const Scalar& y = matrix( i, j );
+            if ( !almostEqual( x.value(), y.value(), 1e-14 ) )
+            {
+                return false;
+            }
+            for ( const auto& p : jet.parameters() )
+            {
+                const EigenRowVector expected
+                    = y.contains( p ) ? y.at( p ) : EigenRowVector::Zero( p->dim() );
+                if ( ( x.at( p ) - expected ).norm() > 1e-14 * ( 1.0 + expected.norm() ) )
+                {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief Returns a matrix with a single unit element.
+ */
+inline Eigen::MatrixXd unit( int rows, int cols, int i, int j )
+{
+    Eigen::MatrixXd out = Eigen::MatrixXd::Zero( rows, cols );
+    out( i, j ) = 1.0;
+    return out;
+}
+
+
+TEST_CASE( "Jet matrices store derivatives as structure of arrays", "[jet_matrix]" )
+{
+    const Eigen::Matrix3d a0 = ( Eigen::Matrix3d{} << 1, 2, 3, -1, 0.5, 4, 2, -3, 1 ).finished();
+    const Eigen::Matrix3d b0 = ( Eigen::Matrix3d{} << 0, 1, -2, 3, 2, 1, -1, 1, 5 ).finished();
+    const JetMatrix< 3, 3 > a = createJet< NamedParameter >( a0, "a" );
+    const JetMatrix< 3, 3 > b = createJet< NamedParameter >( b0, "b" );
+    const MatrixT< 3, 3 > am = a.toMatrix();
+    const MatrixT< 3, 3 > bm = b.toMatrix();
+    const Scalar s{ 1.5, "s" };
+
+    SECTION( "Creation and element access" )
+    {
+        REQUIRE( a.rows() == 3 );
+        REQUIRE( a.cols() == 3 );
+        REQUIRE( a.dim() == 9 );
+        REQUIRE( a.parameters().size() == 1 );
+        REQUIRE( a.value() == a0 );
+        REQUIRE( a( 1, 2 ).value() == 4.0 );
+        REQUIRE( a( 1, 2 ).partial().toDense() == EigenRowVector::Unit( 9, 7 ) );
+        REQUIRE( a.slice( 7 ) == unit( 3, 3, 1, 2 ) );
+        REQUIRE( JetMatrix< 3, 3 >{ a0 }.dim() == 0 );
+        REQUIRE_THROWS( JetMatrix< 3, 3 >{ a0, a.layout(), Eigen::MatrixXd::Zero( 9, 3 ) } );
+    }
+
+    SECTION( "Conversion from and to matrices of scalars" )
+    {
+        MatrixT< 3, 3 > m = am;
+        m( 0, 1 ) = Scalar{ am( 0, 1 ) * s };
+        m( 2, 2 ) = Scalar{ 7.0 };
+        const JetMatrix< 3, 3 > x{ m };
+
+        REQUIRE( x.dim() == 10 );
+        REQUIRE( x.layout() == Scalar{ am( 0, 0 ) + s }.layout() );
+        REQUIRE( sameAs( x, m ) );
+        REQUIRE( sameAs( JetMatrix< 3, 3 >{ x.toMatrix() }, m ) );
+    }
+
+    SECTION( "Arithmetic agrees with elementwise arithmetic" )
+    {
+        REQUIRE( sameAs( a + b, MatrixT< 3, 3 >{ am + bm } ) );
+        REQUIRE( sameAs( a - 2.0 * b, MatrixT< 3, 3 >{ am - 2.0 * bm } ) );
+        REQUIRE( sameAs( -a / 4.0, MatrixT< 3, 3 >{ -am / 4.0 } ) );
+        REQUIRE( sameAs( s * a - b, MatrixT< 3, 3 >{ s * am - bm } ) );
+        REQUIRE( sameAs( ( a + b ) * s, MatrixT< 3, 3 >{ ( am + bm ) * s } ) );
+        REQUIRE( sameAs( a.transpose() + b, MatrixT< 3, 3 >{ am.transpose() + bm } ) );
+
+        JetMatrix< 3, 3 > x = a;
+        x.multAndAdd( b, 0.5 );
+        x *= 2.0;
+        x -= a;
+        REQUIRE( sameAs( x, MatrixT< 3, 3 >{ am + bm } ) );
+    }
+
+    SECTION( "Dynamic and rectangular matrices" )
+    {
+        const Eigen::MatrixXd v0 = Eigen::MatrixXd::Random( 4, 2 );
+        const JetMatrixX v = createJet< NamedParameter >( v0, "v" );
+
+        REQUIRE( v.dim() == 8 );
+        REQUIRE( v.transpose().rows() == 2 );
+        REQUIRE( v.transpose().slice( 5 ) == unit( 2, 4, 1, 1 ) );
+        REQUIRE( sameAs( v * s, Matrix{ v.toMatrix() * s } ) );
+    }
+}
+
+
+TEST_CASE( "Jet matrix products follow the product rule", "[jet_matrix]" )
+{
+    const Eigen::Matrix3d a0 = ( Eigen::Matrix3d{} << 1, 2, 3, -1, 0.5, 4, 2, -3, 1 ).finished();
+    const Eigen::Matrix3d b0 = ( Eigen::Matrix3d{} << 0, 1, -2, 3, 2, 1, -1, 1, 5 ).finished();
+    const JetMatrix< 3, 3 > a = createJet< NamedParameter >( a0, "a" );
+    const JetMatrix< 3, 3 > b = createJet< NamedParameter >( b0, "b" );
+    const MatrixT< 3, 3 > am = a.toMatrix();
+    const MatrixT< 3, 3 > bm = b.toMatrix();
+    const Scalar s{ 1.5, "s" };
+
+    SECTION( "Products agree with elementwise products" )
+    {
+        REQUIRE( sameAs( a * b, MatrixT< 3, 3 >{ am * bm } ) );
+        REQUIRE( sameAs( a * a, MatrixT< 3, 3 >{ am * am } ) );
+        REQUIRE( sameAs( ( s * a ) * b, MatrixT< 3, 3 >{ ( s * am ) * bm } ) );
+        REQUIRE( sameAs( a * JetMatrix< 3, 3 >{ b0 }, MatrixT< 3, 3 >{ am * b0 } ) );
+        REQUIRE( sameAs( JetMatrix< 3, 3 >{ a0 } * b, MatrixT< 3, 3 >{ a0 * bm } ) );
+        REQUIRE( ( JetMatrix< 3, 3 >{ a0 } * JetMatrix< 3, 3 >{ b0 } ).dim() == 0 );
+        REQUIRE( sameAs( JetMatrix< 3, 3 >{ product( am, bm ) }, MatrixT< 3, 3 >{ am * bm } ) );
+    }
+
+    SECTION( "Rectangular and dynamic products" )
+    {
+        const Eigen::MatrixXd v0 = Eigen::MatrixXd::Random( 3, 2 );
+        const JetMatrixX v = createJet< NamedParameter >( v0, "v" );
+        const JetMatrixX ax{ a.value(), a.layout(), a.partial() };
+
+        REQUIRE( sameAs( ax * v, Matrix{ am * v.toMatrix() } ) );
+        REQUIRE( sameAs( v.transpose() * ax, Matrix{ v.toMatrix().transpose() * am } ) );
+        REQUIRE_THROWS( v * ax );
+
+        const JetVectorT< 3 > x = createJet< NamedParameter >( Eigen::Vector3d{ 1, -2, 3 }, "x" );
+        REQUIRE( sameAs( a * x, VectorT< 3 >{ am * x.toMatrix() } ) );
+    }
+}
@@ -0,0 +1,194 @@
+#include "TestSuite.h"
+#include "src/LinearAlgebra.h"
+
+
+using namespace metal;
+
+
+/**
+ * @brief Checks that two jet matrices agree in values and partials, up to a relative tolerance.
+ */
+template< int Rows, int Cols >
+bool near( const JetMatrix< Rows, Cols >& x, const JetMatrix< Rows, Cols >& y, double tolerance )
+{
+    if ( x.rows() != y.rows() || x.cols() != y.cols() || x.layout() != y.layout() )
+    {
+        return false;
+    }
+    return ( x.value() - y.value() ).norm() <= tolerance * ( 1.0 + y.value().norm() )
+        && ( x.partial() - y.partial() ).norm() <= tolerance * ( 1.0 + y.partial().norm() );
+}
+
+
+TEST_CASE( "Linear systems are solved with derivatives", "[linear_algebra]" )
+{
+    const Eigen::Matrix3d a0 = ( Eigen::Matrix3d{} << 4, 2, 3, -1, 5, 4, 2, -3, 6 ).finished();
+    const Eigen::Matrix< double, 3, 2 > b0
+        = ( Eigen::Matrix< double, 3, 2 >{} << 0, 1, -2, 3, 2, 1 ).finished();
+    const JetMatrix< 3, 3 > a = createJet< NamedParameter >( a0, "a" );
+    const JetMatrix< 3, 2 > b = createJet< NamedParameter >( b0, "b" );
+
+    SECTION( "The solution satisfies the system and its derivative" )
+    {
+        const JetMatrix< 3, 2 > x = solve( a, b );
+        JetMatrix< 3, 2 > expected = b;
+        expected.extend( x.layout() );
+
+        REQUIRE( x.parameters().size() == 2 );
+        REQUIRE( x.value().isApprox( a0.partialPivLu().solve( b0 ) ) );
+        REQUIRE( near( a * x, expected, 1e-14 ) );
+    }
+
+    SECTION( "Matrices of scalars are solved through jet matrices" )
+    {
+        const MatrixT< 3, 3 > am = a.toMatrix();
+        const MatrixT< 3, 2 > bm = b.toMatrix();
+        const MatrixT< 3, 2 > xm = solve( am, bm );
+        JetMatrix< 3, 2 > expected = b;
+        expected.extend( JetMatrix< 3, 2 >{ xm }.layout() );
+
+        REQUIRE( near( JetMatrix< 3, 2 >{ xm }, solve( a, b ), 1e-14 ) );
+        REQUIRE( near( JetMatrix< 3, 2 >{ MatrixT< 3, 2 >{ am * xm } }, expected, 1e-14 ) );
+    }
+
+    SECTION( "Constant operands and dynamic sizes" )
+    {
+        const JetMatrix< 3, 2 > xa = solve( a, JetMatrix< 3, 2 >{ b0 } );
+        const JetMatrix< 3, 2 > xb = solve( JetMatrix< 3, 3 >{ a0 }, b );
+        REQUIRE( xa.layout() == a.layout() );
+        REQUIRE( xb.layout() == b.layout() );
+        Eigen::MatrixXd inverses = Eigen::MatrixXd::Zero( 6, 6 );
+        inverses.topLeftCorner( 3, 3 ) = a0.inverse();
+        inverses.bottomRightCorner( 3, 3 ) = a0.inverse();
+        REQUIRE( xb.partial().isApprox( inverses ) );
+        REQUIRE( solve( JetMatrix< 3, 3 >{ a0 }, JetMatrix< 3, 2 >{ b0 } ).dim() == 0 );
+
+        const JetMatrixX ax{ a.value(), a.layout(), a.partial() };
+        const JetMatrixX bx{ b.value(), b.layout(), b.partial() };
+        const JetMatrixX x = solve( ax, bx );
+        REQUIRE( x.value() == solve( a, b ).value() );
+        REQUIRE( x.partial() == solve( a, b ).partial() );
+        const Eigen::MatrixXd zero = Eigen::MatrixXd::Zero( 2, 2 );
+        REQUIRE_THROWS( solve( ax, JetMatrixX{ zero } ) );
+
+        const metal::Vector v
+            = solve( Matrix{ a.toMatrix() }, metal::Vector{ b.toMatrix().col( 0 ) } );
+        REQUIRE( v.size() == 3 );
+    }
+}
+
+
+TEST_CASE( "Inverses and determinants have analytic derivatives", "[linear_algebra]" )
+{
+    const Eigen::Matrix3d a0 = ( Eigen::Matrix3d{} << 4, 2, 3, -1, 5, 4, 2, -3, 6 ).finished();
+    const JetMatrix< 3, 3 > a = createJet< NamedParameter >( a0, "a" );
+    const MatrixT< 3, 3 > am = a.toMatrix();
+    const Scalar s{ 2.0, "s" };
+
+    SECTION( "Inverse" )
+    {
+        const JetMatrix< 3, 3 > inv = inverse( a );
+        const Eigen::Matrix3d identity = Eigen::Matrix3d::Identity();
+        JetMatrix< 3, 3 > expected{ identity };
+        expected.extend( a.layout() );
+
+        REQUIRE( inv.value().isApprox( a0.inverse() ) );
+        REQUIRE( near( a * inv, expected, 1e-14 ) );
+        const JetMatrix< 3, 3 > unscaled = inverse( s * a ) * s;
+        JetMatrix< 3, 3 > extended = inv;
+        extended.extend( unscaled.layout() );
+        REQUIRE( near( unscaled, extended, 1e-14 ) );
+        REQUIRE( near( JetMatrix< 3, 3 >{ inverse( am ) }, inv, 1e-14 ) );
+        REQUIRE( inverse( JetMatrix< 3, 3 >{ a0 } ).dim() == 0 );
+    }
+
+    SECTION( "Determinant and log-determinant" )
+    {
+        const Scalar det = determinant( a );
+        const Scalar expected = am.determinant();
+        REQUIRE( almostEqual( det.value(), a0.determinant(), 1e-14 ) );
+        REQUIRE( ( det.partial().toDense() - expected.partial().toDense() ).norm() < 1e-12 );
+        REQUIRE( almostEqual( determinant( am ).value(), det.value(), 1e-14 ) );
+
+        const Scalar logDet = logDeterminant( a );
+        REQUIRE( almostEqual( logDet.value(), std::log( a0.determinant() ), 1e-14 ) );
+        REQUIRE( ( logDet.partial().toDense() - det.partial().toDense() / det.value() ).norm()
+            < 1e-14 );
+        const Eigen::Matrix3d negated = -a0;
+        REQUIRE( almostEqual(
+            logDeterminant( JetMatrix< 3, 3 >{ negated } ).value(), logDet.value(), 1e-14 ) );
+
+        const Scalar scaled = logDeterminant( s * a );
+        REQUIRE( almostEqual( scaled.value(), logDet.value() + 3.0 * std::log( 2.0 ), 1e-14 ) );
+        REQUIRE( almostEqual( scaled.at( s.parameters().front() )( 0 ), 1.5, 1e-14 ) );
+    }
+
+    SECTION( "Singular matrices" )
+    {
+        const Eigen::Matrix3d rank2 = ( Eigen::Matrix3d{} << 1, 2, 3, 4, 5, 6, 7, 8, 9 ).finished();
+        const Eigen::Matrix3d rank1 = Eigen::Matrix3d::Ones();
+        const Eigen::Vector3d ones = Eigen::Vector3d::Ones();
+        for ( const Eigen::Matrix3d& m0 : { rank2, rank1 } )
+        {
+            const JetMatrix< 3, 3 > m = createJet< NamedParameter >( m0, "m" );
+            const Scalar det = determinant( m );
+            const Scalar expected = m.toMatrix().determinant();
+
+            REQUIRE( det.partial().toDense().allFinite() );
+            REQUIRE( ( det.partial().toDense() - expected.partial().toDense() ).norm() < 1e-12 );
+            REQUIRE_THROWS_AS( inverse( m ), std::runtime_error );
+            REQUIRE_THROWS_AS( logDeterminant( m ), std::runtime_error );
+            REQUIRE_THROWS_AS( solve( m, JetMatrix< 3, 1 >{ ones } ), std::runtime_error );
+        }
+    }
+}
+
+
+TEST_CASE( "Decompositions propagate derivatives", "[linear_algebra]" )
+{
+    const Eigen::Matrix< double, 4, 3 > b0
+        = ( Eigen::Matrix< double, 4, 3 >{} << 4, 2, 3, -1, 5, 4, 2, -3, 6, 1, 0, -2 ).finished();
+    const JetMatrix< 4, 3 > b = createJet< NamedParameter >( b0, "b" );
+    const Eigen::Matrix3d identity = Eigen::Matrix3d::Identity();
+
+    SECTION( "Cholesky decomposition" )
+    {
+        const JetMatrix< 3, 3 > a = b.transpose() * b + JetMatrix< 3, 3 >{ identity };
+        const JetMatrix< 3, 3 > l = cholesky( a );
+
+        REQUIRE( l.value().isApprox( a.value().llt().matrixL().toDenseMatrix() ) );
+        REQUIRE( near( l * l.transpose(), a, 1e-14 ) );
+        for ( int k = 0; k < l.dim(); k++ )
+        {
+            const Eigen::Matrix3d slice = l.slice( k );
+            REQUIRE( slice.triangularView< Eigen::StrictlyUpper >().toDenseMatrix().isZero() );
+        }
+        REQUIRE( near( JetMatrix< 3, 3 >{ cholesky( a.toMatrix() ) }, l, 1e-14 ) );
+        REQUIRE_THROWS( cholesky( -a ) );
+    }
+
+    SECTION( "QR decomposition" )
+    {
+        const QRFactors< JetMatrix< 4, 3 >, JetMatrix< 3, 3 > > f = qr( b );
+        JetMatrix< 3, 3 > orthonormal{ identity };
+        orthonormal.extend( b.layout() );
+
+        REQUIRE( near( f.q * f.r, b, 1e-14 ) );
+        REQUIRE( near( f.q.transpose() * f.q, orthonormal, 1e-14 ) );
+        for ( int k = 0; k < f.r.dim(); k++ )
+        {
+            const Eigen::Matrix3d slice = f.r.slice( k );
+            REQUIRE( slice.triangularView< Eigen::StrictlyLower >().toDenseMatrix().isZero() );
+        }
+
+        const QRFactors< MatrixT< 4, 3 >, MatrixT< 3, 3 > > m = qr( b.toMatrix() );
+        REQUIRE( near( JetMatrix< 4, 3 >{ m.q }, f.q, 1e-14 ) );
+        REQUIRE( near( JetMatrix< 3, 3 >{ m.r }, f.r, 1e-14 ) );
+        REQUIRE_THROWS( qr( b.transpose() ) );
+
+        Eigen::Matrix< double, 4, 3 > dependent = b0;
+        dependent.col( 2 ) = 0.3 * b0.col( 0 ) + 0.7 * b0.col( 1 );
+        REQUIRE_THROWS_AS(
+            qr( createJet< NamedParameter >( dependent, "d" ) ), std::runtime_error );
+    }
+}
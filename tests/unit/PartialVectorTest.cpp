@@ -0,0 +1,250 @@
+#include "catch.hpp"
+#include "src/PartialVector.h"
+
+
+using PartialVector = metal::PartialVector;
+
+
+inline bool equal( double left, double right )
+{
+    return std::fabs( left - right ) <= 0.0;
+}
+
+inline PartialVector sequence( int size )
+{
+    PartialVector out;
+    out.resize( size );
+    for ( int i = 0; i < size; i++ )
+    {
+        out.data()[i] = i + 1.0;
+    }
+    return out;
+}
+
+
+TEST_CASE( "PartialVector can be constructed", "[partial_vector_construct]" )
+{
+    SECTION( "Default constructor" )
+    {
+        const PartialVector x;
+        REQUIRE( x.size() == 0 );
+        REQUIRE( x.isInline() );
+    }
+
+    SECTION( "Small and large vectors" )
+    {
+        const PartialVector x = sequence( PartialVector::InlineSize );
+        REQUIRE( x.size() == PartialVector::InlineSize );
+        REQUIRE( x.isInline() );
+
+        const PartialVector y = sequence( PartialVector::InlineSize + 1 );
+        REQUIRE( y.size() == PartialVector::InlineSize + 1 );
+        REQUIRE( !y.isInline() );
+    }
+
+    SECTION( "Construction from Eigen expression" )
+    {
+        const PartialVector x{ metal::EigenRowVector::Constant( 3, 2.0 ) };
+        REQUIRE( x.size() == 3 );
+        REQUIRE( x.isInline() );
+        REQUIRE( x.map() == metal::EigenRowVector::Constant( 3, 2.0 ) );
+    }
+
+    SECTION( "Copy and move constructor" )
+    {
+        for ( int size : { 4, 12 } )
+        {
+            const PartialVector x = sequence( size );
+
+            const PartialVector y{ x };
+            REQUIRE( x.data() != y.data() );
+            REQUIRE( x.map() == y.map() );
+
+            PartialVector tmp{ x };
+            const double* data = tmp.data();
+            const PartialVector z{ std::move( tmp ) };
+            REQUIRE( tmp.size() == 0 );
+            REQUIRE( z.map() == x.map() );
+            REQUIRE( ( data == z.data() ) == !z.isInline() );
+        }
+    }
+
+    SECTION( "Copy and move assignment" )
+    {
+        for ( int size : { 4, 12 } )
+        {
+            const PartialVector x = sequence( size );
+
+            PartialVector y = sequence( 2 );
+            y = x;
+            REQUIRE( x.data() != y.data() );
+            REQUIRE( x.map() == y.map() );
+
+            PartialVector z = sequence( 20 );
+            z = sequence( size );
+            REQUIRE( z.map() == x.map() );
+        }
+    }
+}
+
+
+TEST_CASE( "PartialVector exposes Eigen views", "[partial_vector_map]" )
+{
+    SECTION( "Zero initialization reuses storage" )
+    {
+        PartialVector x = sequence( 12 );
+        const double* data = x.data();
+        x.setZero( 10 );
+        REQUIRE( x.data() == data );
+        REQUIRE( x.size() == 10 );
+        REQUIRE( x.map().isZero( 0.0 ) );
+    }
+
+    SECTION( "Growth keeps the elements" )
+    {
+        PartialVector x = sequence( 6 );
+        x.grow( 10 );
+        const double* data = x.data();
+        REQUIRE( x.size() == 10 );
+        REQUIRE( equal( x.data()[5], 6.0 ) );
+        REQUIRE( x.map().tail( 4 ).isZero( 0.0 ) );
+
+        x.grow( 16 );
+        REQUIRE( x.data() == data );
+        x.grow( 20 );
+        REQUIRE( x.data() != data );
+        REQUIRE( equal( x.data()[5], 6.0 ) );
+        REQUIRE( x.map().tail( 14 ).isZero( 0.0 ) );
+        data = x.data();
+        x.grow( 32 );
+        REQUIRE( x.data() == data );
+    }
+
+    SECTION( "Add segment to segment" )
+    {
+        const PartialVector x = sequence( 4 );
+        PartialVector y;
+        y.setZero( 4 );
+
+        y.segment( 1, 2 ) += 2.0 * x.segment( 0, 2 );
+        REQUIRE( equal( y.data()[0], 0.0 ) );
+        REQUIRE( equal( y.data()[1], 2.0 ) );
+        REQUIRE( equal( y.data()[2], 4.0 ) );
+        REQUIRE( equal( y.data()[3], 0.0 ) );
+    }
+}
+
+
+TEST_CASE( "PartialVector has a sparse mode", "[partial_vector_sparse]" )
+{
+    const int size = 4 * PartialVector::SparseMinSize;
+
+    SECTION( "Compression of low fill vectors" )
+    {
+        PartialVector x;
+        x.setZero( size );
+        x.data()[3] = 1.0;
+        x.data()[100] = -2.0;
+        const metal::EigenRowVector dense = x.map();
+
+        x.compress();
+        REQUIRE( x.isSparse() );
+        REQUIRE( x.isInline() );
+        REQUIRE( x.size() == size );
+        REQUIRE( x.nonZeros() == 2 );
+        REQUIRE( x.toDense() == dense );
+
+        x.densify();
+        REQUIRE( !x.isSparse() );
+        REQUIRE( x.map() == dense );
+    }
+
+    SECTION( "Short or high fill vectors stay dense" )
+    {
+        PartialVector x;
+        x.setZero( PartialVector::SparseMinSize - 1 );
+        x.compress();
+        REQUIRE( !x.isSparse() );
+
+        PartialVector y = sequence( size );
+        y.compress();
+        REQUIRE( !y.isSparse() );
+    }
+
+    SECTION( "Merging of index/value pairs" )
+    {
+        std::vector< PartialVector::Entry > entries{ { 7, 1.0 }, { 2, 2.0 }, { 7, 3.0 } };
+        PartialVector x;
+        x.setSparse( size, entries );
+        REQUIRE( x.isSparse() );
+        REQUIRE( x.nonZeros() == 2 );
+
+        metal::EigenRowVector segment = metal::EigenRowVector::Zero( 6 );
+        x.addTo( segment.data(), 2, 6, 0.5 );
+        REQUIRE( equal( segment[0], 1.0 ) );
+        REQUIRE( equal( segment[5], 2.0 ) );
+        REQUIRE( equal( segment.sum(), 3.0 ) );
+
+        std::vector< PartialVector::Entry > full;
+        for ( int i = 0; i < size; i++ )
+        {
+            full.emplace_back( i, 1.0 );
+        }
+        x.setSparse( size, full );
+        REQUIRE( !x.isSparse() );
+        REQUIRE( x.map() == metal::EigenRowVector::Ones( size ) );
+    }
+
+    SECTION( "Copy, arithmetic and addition" )
+    {
+        std::vector< PartialVector::Entry > entries{ { 1, 1.0 }, { 5, 2.0 } };
+        PartialVector x;
+        x.setSparse( size, entries );
+
+        PartialVector y{ x };
+        REQUIRE( y.isSparse() );
+        REQUIRE( y.toDense() == x.toDense() );
+
+        y *= 3.0;
+        y.add( x, 1.0 );
+        REQUIRE( y.isSparse() );
+        REQUIRE( y.toDense() == 4.0 * x.toDense() );
+
+        entries = { { 2, 1.0 } };
+        PartialVector z;
+        z.setSparse( size, entries );
+        y.add( z, -1.0 );
+        REQUIRE( y.nonZeros() == 3 );
+        REQUIRE( equal( y.toDense()[2], -1.0 ) );
+
+        PartialVector w;
+        w.setZero( size );
+        w.add( y, 2.0 );
+        REQUIRE( w.map() == 2.0 * y.toDense() );
+    }
+
+    SECTION( "Moves never allocate" )
+    {
+        REQUIRE( std::is_nothrow_move_constructible< PartialVector >::value );
+        REQUIRE( std::is_nothrow_move_assignable< PartialVector >::value );
+
+        std::vector< PartialVector::Entry > entries{ { 1, 1.0 }, { 5, 2.0 } };
+        PartialVector x;
+        x.setSparse( size, entries );
+        const metal::EigenRowVector dense = x.toDense();
+
+        PartialVector y;
+        y.setZero( 2 * size );
+        y = std::move( x );
+        REQUIRE( y.isSparse() );
+        REQUIRE_FALSE( y.isInline() );
+        REQUIRE( y.toDense() == dense );
+        REQUIRE( x.size() == 0 );
+
+        const double* data = y.data();
+        const PartialVector z{ std::move( y ) };
+        REQUIRE( z.isSparse() );
+        REQUIRE( z.data() == data );
+        REQUIRE( z.toDense() == dense );
+    }
+}
@@ -0,0 +1,128 @@
+#include "TestSuite.h"
+#include <array>
+
+
+using namespace metal;
+
+
+/**
+ * @brief Tells whether a term of a given type can be added to an accumulator.
+ */
+template< typename Term, typename = void >
+struct CanAdd : std::false_type
+{
+};
+
+template< typename Term >
+struct CanAdd< Term,
+    decltype( void( std::declval< ScalarAccumulator& >().add( std::declval< Term >() ) ) ) >
+    : std::true_type
+{
+};
+
+
+TEST_CASE( "Scalar accumulators sum weighted terms", "[scalar_accumulator]" )
+{
+    const Scalar a{ 1.0, "a" };
+    const Scalar b{ 2.0, "b" };
+    const Scalar c{ 3.0, "c" };
+    const Scalar ab = a * b;
+    const Scalar bc = b + c;
+    const Scalar d{ 4.0 };
+
+    SECTION( "Terms with different parameters" )
+    {
+        ScalarAccumulator acc;
+        acc.add( ab, 2.0 ).add( bc, -1.0 ).add( d, 0.5 ).add( a );
+        const Scalar x = acc;
+
+        REQUIRE_VALUE_EQUAL( x, 2.0 * 2.0 - 5.0 + 2.0 + 1.0 );
+        REQUIRE( x.size() == 3 );
+        REQUIRE( x.parameters() == Scalar{ a + b + c }.parameters() );
+        REQUIRE( almostEqual( x.at( a )[0], 5.0 ) );
+        REQUIRE( almostEqual( x.at( b )[0], 1.0 ) );
+        REQUIRE( almostEqual( x.at( c )[0], -1.0 ) );
+    }
+
+    SECTION( "Terms sharing a layout" )
+    {
+        const Scalar u = ab + c;
+        const Scalar v = sin( a ) * c - b;
+        ScalarAccumulator acc{ 2 };
+        acc.add( u, 0.5 ).add( v, 0.25 );
+
+        REQUIRE( acc.parameters() == u.parameters() );
+
+        const Scalar x = acc;
+        const Scalar y{ 0.5 * u + 0.25 * v };
+
+        REQUIRE( x.layout() == u.layout() );
+        REQUIRE( almostEqual( x.value(), y.value(), 1e-15 ) );
+        REQUIRE( x.partial().toDense() == y.partial().toDense() );
+    }
+
+    SECTION( "Accumulation gives the same partials as scattering" )
+    {
+        ScalarAccumulator acc;
+        acc.add( ab, 2.0 ).add( bc, -1.0 );
+        const Scalar x{ acc, Evaluation::Accumulate };
+        const Scalar y{ acc, Evaluation::Scatter };
+
+        REQUIRE( x.partial().toDense() == y.partial().toDense() );
+    }
+
+    SECTION( "Empty and cleared accumulators" )
+    {
+        ScalarAccumulator acc;
+
+        REQUIRE_PARTIALS_EMPTY( Scalar{ acc } );
+
+        acc.add( ab );
+        REQUIRE( acc.size() == 2 );
+
+        acc.clear();
+        acc.add( d, 2.0 );
+        REQUIRE_VALUE_EQUAL( acc, 8.0 );
+        REQUIRE( acc.parameters().empty() );
+    }
+
+    SECTION( "Only terms outliving the call can be added" )
+    {
+        REQUIRE( CanAdd< const Scalar& >::value );
+        REQUIRE( CanAdd< Scalar& >::value );
+        REQUIRE_FALSE( CanAdd< Scalar >::value );
+        REQUIRE_FALSE( CanAdd< decltype( a * b ) >::value );
+        REQUIRE_FALSE( CanAdd< const decltype( a * b )& >::value );
+    }
+
+    SECTION( "Parameters are merged once at evaluation" )
+    {
+        ScalarAccumulator acc;
+        acc.add( d ).add( ab );
+        REQUIRE( acc.parameters() == ab.parameters() );
+        REQUIRE( Scalar{ acc }.layout() == ab.layout() );
+
+        acc.add( bc ).add( ab ).add( bc ).add( ab );
+        REQUIRE( acc.parameters() == Scalar{ a + b + c }.parameters() );
+        REQUIRE( acc.dim() == 3 );
+        REQUIRE( acc.contains( c.parameters().front() ) );
+        REQUIRE( Scalar{ acc }.layout() == Scalar{ a + b + c }.layout() );
+    }
+}
+
+
+TEST_CASE( "Linear combinations of scalars", "[scalar_linear_combination]" )
+{
+    const Scalar a{ 1.0, "a" };
+    const Scalar b{ 2.0, "b" };
+    const std::vector< Scalar > k{ a * b, a + b, sqr( a ), b / a };
+    const std::array< double, 4 > w{ { 1.0 / 6.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 6.0 } };
+
+    const Scalar x = linearCombination( w, k );
+    const Scalar y{ w[0] * k[0] + w[1] * k[1] + w[2] * k[2] + w[3] * k[3] };
+
+    REQUIRE( almostEqual( x.value(), y.value(), 1e-15 ) );
+    REQUIRE( almostEqual( x.at( a )[0], y.at( a )[0], 1e-15 ) );
+    REQUIRE( almostEqual( x.at( b )[0], y.at( b )[0], 1e-15 ) );
+    REQUIRE_THROWS( linearCombination( std::vector< double >{ 1.0 }, k ) );
+}
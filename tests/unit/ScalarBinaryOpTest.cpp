@@ -1,4 +1,6 @@
 #include "TestSuite.h"
+#include <thread>
+#include <vector>
 
 
 inline double add( double x, double y ) { return x + y; }
@@ -21,9 +23,170 @@ inline double arctan2( double x, double y ) { return atan2( x, y ); }
 inline metal::ScalarBinaryOp< metal::Scalar, metal::Scalar, metal::Atan2Op >
 arctan2( const metal::Scalar& x, const metal::Scalar& y ) { return atan2( x, y ); }
 
+inline double power( double x, double y ) { return std::pow( x, y ); }
+inline metal::ScalarBinaryOp< metal::Scalar, metal::Scalar, metal::BinaryPowerOp >
+power( const metal::Scalar& x, const metal::Scalar& y ) { return pow( x, y ); }
+
+inline double hypotenuse( double x, double y ) { return std::hypot( x, y ); }
+inline metal::ScalarBinaryOp< metal::Scalar, metal::Scalar, metal::HypotOp >
+hypotenuse( const metal::Scalar& x, const metal::Scalar& y ) { return hypot( x, y ); }
+
 
 TEST_SCALAR_BINARY( "Binary addition operation", "[scalar_binary_add]", add, -10, 10, -10, 10, 100 )
 TEST_SCALAR_BINARY( "Binary subtraction operation", "[scalar_binary_sub]", sub, -10, 10, -10, 10, 100 )
 TEST_SCALAR_BINARY( "Binary multiplication operation", "[scalar_binary_mul]", mul, -10, 10, -10, 10, 100 )
 TEST_SCALAR_BINARY( "Binary division operation", "[scalar_binary_div]", div, -10, 10, -10, 10, 100 )
 TEST_SCALAR_BINARY( "Binary arc tangent operation", "[scalar_binary_atan2]", arctan2, -10, 10, -10, 10, 100 )
+TEST_SCALAR_BINARY( "Binary power operation", "[scalar_binary_pow]", power, 0.1, 5, -3, 3, 100 )
+TEST_SCALAR_BINARY( "Binary hypotenuse operation", "[scalar_binary_hypot]", hypotenuse, -10, 10, -10, 10, 100 )
+
+
+TEST_CASE( "Binary operations merge the parameters of their operands", "[scalar_binary_parameters]" )
+{
+    const metal::Scalar a{ 1.0, "a" };
+    const metal::Scalar b{ 2.0, "b" };
+    const metal::Scalar c{ 3.0, "c" };
+    const metal::Scalar d{ 4.0 };
+    const metal::Scalar ac = a + c;
+    const metal::Scalar bc = b * c;
+
+    SECTION( "Union in canonical order" )
+    {
+        const auto x = ac - bc;
+        const metal::ParameterPtrVector expected{ a.parameters().front(), b.parameters().front(),
+            c.parameters().front() };
+
+        REQUIRE( x.parameters() == expected );
+        REQUIRE( x.size() == 3 );
+        REQUIRE( x.dim() == 3 );
+        REQUIRE( x.contains( b.parameters().front() ) );
+        REQUIRE( !x.contains( nullptr ) );
+    }
+
+    SECTION( "Operands with the same parameters share their layout" )
+    {
+        REQUIRE( ( ac * d ).parameters() == ac.parameters() );
+        REQUIRE( ( d * bc ).parameters() == bc.parameters() );
+        REQUIRE( metal::Scalar{ ac / ac }.layout() == ac.layout() );
+        REQUIRE( metal::Scalar{ d * bc }.layout() == bc.layout() );
+        REQUIRE( ( d + d ).parameters().empty() );
+        REQUIRE( ( d + d ).dim() == 0 );
+    }
+}
+
+
+struct FusedHypotOp
+{
+    metal::BinaryResult apply( double left, double right ) const
+    {
+        const double tmp = std::sqrt( left * left + right * right );
+        return metal::BinaryResult{ tmp, left / tmp, right / tmp };
+    }
+};
+
+TEST_CASE( "Binary operations with fused partials", "[scalar_binary_protocol]" )
+{
+    const metal::Scalar x{ 3.0, "x" };
+    const metal::Scalar y{ 4.0, "y" };
+    const metal::Scalar z{ metal::ScalarBinaryOp< metal::Scalar, metal::Scalar, FusedHypotOp >{
+        x, y, FusedHypotOp{} } };
+
+    REQUIRE( almostEqual( z.value(), 5.0 ) );
+    REQUIRE( almostEqual( z.at( x )[0], 0.6 ) );
+    REQUIRE( almostEqual( z.at( y )[0], 0.8 ) );
+}
+
+
+TEST_CASE( "Binary arc tangent evaluated from several threads", "[scalar_binary_atan2_threads]" )
+{
+    const metal::Scalar x{ 3.0, "x" };
+    const metal::Scalar y{ 4.0, "y" };
+    const metal::Scalar z{ 2.0, "z" };
+    const int count = 4;
+    const int repeats = 1000;
+
+    // All threads evaluate the same expression nodes. Nodes reference their operands, so every
+    // sub-expression is named to outlive the threads.
+    const auto angle = atan2( x, y );
+    const auto xz = x * z;
+    const auto e = angle * z;
+    const auto sum = angle + xz + y;
+
+    std::vector< int > failures( count, 0 );
+    std::vector< metal::Scalar > results( count );
+    std::vector< std::thread > threads;
+    for ( int t = 0; t < count; t++ )
+    {
+        threads.emplace_back( [&, t]() {
+            const double angle = std::atan2( 3.0, 4.0 );
+            for ( int i = 0; i < repeats; i++ )
+            {
+                const metal::Scalar u{ e };
+                const metal::Scalar v{ sum };
+                if ( !almostEqual( u.value(), 2.0 * angle, 1e-15 )
+                    || !almostEqual( u.at( x )[0], 2.0 * 4.0 / 25.0, 1e-15 )
+                    || !almostEqual( u.at( y )[0], -2.0 * 3.0 / 25.0, 1e-15 )
+                    || !almostEqual( u.at( z )[0], angle, 1e-15 )
+                    || !almostEqual( v.value(), angle + 10.0, 1e-15 )
+                    || !almostEqual( v.at( x )[0], 4.0 / 25.0 + 2.0, 1e-15 )
+                    || !almostEqual( v.at( y )[0], -3.0 / 25.0 + 1.0, 1e-15 )
+                    || !almostEqual( v.at( z )[0], 3.0, 1e-15 ) )
+                {
+                    failures[static_cast< size_t >( t )]++;
+                }
+            }
+            results[static_cast< size_t >( t )] = metal::Scalar{ e };
+        } );
+    }
+    for ( auto& thread : threads )
+    {
+        thread.join();
+    }
+
+    REQUIRE( failures == std::vector< int >( count, 0 ) );
+
+    // Every thread interns its own layouts, which still combine with the ones of other threads
+    metal::Scalar total{ e };
+    for ( const auto& result : results )
+    {
+        total += result;
+    }
+    REQUIRE( total.size() == 3 );
+    REQUIRE( almostEqual( total.at( x )[0], 5.0 * 2.0 * 4.0 / 25.0, 1e-15 ) );
+    REQUIRE( almostEqual( total.at( z )[0], 5.0 * std::atan2( 3.0, 4.0 ), 1e-15 ) );
+}
+
+
+TEST_CASE( "Scalars without parameters behave like numbers", "[scalar_binary_constant]" )
+{
+    const metal::Scalar x{ 0.5, "x" };
+    const metal::Scalar y{ 2.0, "y" };
+    const metal::Scalar c1{ 0.3 };
+    const metal::Scalar c2{ 1.7 };
+
+    const auto u = c1 * x;
+    REQUIRE( u.parameters() == x.parameters() );
+    REQUIRE( u.dim() == 1 );
+    REQUIRE( ( c1 + c2 ).parameters().empty() );
+    REQUIRE( !( c1 * c2 ).contains( x.parameters().front() ) );
+
+    for ( const auto mode : { metal::Evaluation::Scatter, metal::Evaluation::Accumulate } )
+    {
+        const metal::Scalar s{ c1 * x * y + c2 * sin( x ) - y / c2 + c1, mode };
+        const metal::Scalar d{ 0.3 * x * y + 1.7 * sin( x ) - y / 1.7 + 0.3, mode };
+
+        REQUIRE( almostEqual( s.value(), d.value(), 1e-15 ) );
+        REQUIRE( s.layout() == d.layout() );
+        REQUIRE( s.at( x ).isApprox( d.at( x ) ) );
+        REQUIRE( s.at( y ).isApprox( d.at( y ) ) );
+    }
+    REQUIRE( ( c1 * x * y ).at( y.parameters().front() ).isApprox( metal::EigenRowVector::Constant( 1, 0.15 ) ) );
+
+    const metal::Scalar n{ -2.0, "n" };
+    const metal::Scalar three{ 3.0 };
+    const auto cubed = pow( n, three );
+    const metal::Scalar p = cubed;
+    REQUIRE( cubed.rightPartial() == 0.0 );
+    REQUIRE_VALUE_EQUAL( p, -8.0 );
+    REQUIRE( almostEqual( p.at( n )[0], 12.0 ) );
+}
@@ -0,0 +1,122 @@
+#include "TestSuite.h"
+#include "src/Matrix.h"
+
+
+using namespace metal;
+
+
+TEST_CASE( "Fixed dimension scalars can be created", "[scalarn_construct]" )
+{
+    SECTION( "Construction without partials" )
+    {
+        const ScalarN< 3 > x{ 1.5 };
+
+        REQUIRE_VALUE_EQUAL( x, 1.5 );
+        REQUIRE( x.dim() == 0 );
+        REQUIRE( x.size() == 0 );
+        REQUIRE( x.layout() == nullptr );
+        REQUIRE( x.partial().isZero( 0.0 ) );
+        REQUIRE_THROWS( x.at( nullptr ) );
+    }
+
+    SECTION( "Construction from parameter" )
+    {
+        const auto p = std::make_shared< NamedParameter >( 2, "p" );
+        const ScalarN< 2 > x{ 2.5, p, Eigen::RowVector2d{ 1.0, 2.0 } };
+
+        REQUIRE_VALUE_EQUAL( x, 2.5 );
+        REQUIRE( x.dim() == 2 );
+        REQUIRE( x.size() == 1 );
+        REQUIRE( x.at( p ) == Eigen::RowVector2d( 1.0, 2.0 ) );
+    }
+
+    SECTION( "Construction from named parameter" )
+    {
+        const ScalarN< 1 > x{ 2.5, "x" };
+
+        REQUIRE_VALUE_EQUAL( x, 2.5 );
+        REQUIRE_PARTIALS_EQUAL( x, 1.0 );
+    }
+
+    SECTION( "Dimension mismatch is detected" )
+    {
+        const auto p = std::make_shared< NamedParameter >( 3, "p" );
+        const Scalar a{ 1.0, "a" };
+        const Scalar b{ 2.0, "b" };
+
+        REQUIRE_THROWS( ScalarN< 2 >{ 1.0, p, Eigen::RowVector2d::Zero() } );
+        REQUIRE_THROWS( ScalarN< 1 >{ a * b } );
+        REQUIRE_NOTHROW( ScalarN< 2 >{ a * b } );
+    }
+
+    SECTION( "Leaves with different layouts are merged" )
+    {
+        const ScalarN< 1 > a{ 1.0, "a" };
+        const ScalarN< 1 > b{ 2.0, "b" };
+        const ScalarN< 2 > x = 3.0 * a + a * b - sqr( a );
+        const Scalar xd = 3.0 * a + a * b - sqr( a );
+
+        REQUIRE_VALUE_EQUAL( x, 4.0 );
+        REQUIRE( x.layout() == xd.layout() );
+        REQUIRE( x.partial() == Eigen::RowVector2d( 3.0, 1.0 ) );
+        REQUIRE( ScalarN< 1 >{ 2.0 * a - a }.layout() == a.layout() );
+    }
+}
+
+
+TEST_CASE( "Fixed dimension scalars take part in expressions", "[scalarn_expression]" )
+{
+    const auto p = std::make_shared< NamedParameter >( 2, "p" );
+    const ScalarN< 2 > x{ 1.5, p, Eigen::RowVector2d{ 1.0, 0.0 } };
+    const ScalarN< 2 > y{ -0.5, p, Eigen::RowVector2d{ 0.0, 1.0 } };
+    const Scalar xd{ 1.5, p, Eigen::RowVector2d{ 1.0, 0.0 } };
+    const Scalar yd{ -0.5, p, Eigen::RowVector2d{ 0.0, 1.0 } };
+
+    SECTION( "Same results as dynamic scalars" )
+    {
+        const ScalarN< 2 > z = sin( x * y ) - 2.0 * y / x + 1.0;
+        const Scalar zd = sin( xd * yd ) - 2.0 * yd / xd + 1.0;
+
+        REQUIRE_VALUE_EQUAL( z, zd.value() );
+        REQUIRE( z.layout() == zd.layout() );
+        REQUIRE( z.partial().isApprox( zd.partial().toDense() ) );
+    }
+
+    SECTION( "Mixing fixed and dynamic scalars" )
+    {
+        const Scalar c{ 3.0, "c" };
+        const Scalar z = x * c + y;
+
+        REQUIRE_VALUE_EQUAL( z, 4.0 );
+        REQUIRE( z.dim() == 3 );
+        REQUIRE( ( x * c + y ).dim() == 3 );
+        REQUIRE( ( x * c + y ).size() == 2 );
+        REQUIRE( z.at( p ) == Eigen::RowVector2d( 3.0, 1.0 ) );
+        REQUIRE( z.at( c ).value() == 1.5 );
+    }
+}
+
+
+TEST_CASE( "Fixed dimension scalars can be used in Eigen matrices", "[scalarn_matrix]" )
+{
+    Eigen::Matrix< double, 3, 1 > v;
+    v << 1.0, 2.0, 3.0;
+    Eigen::Matrix3d m;
+    m << 1.0, 2.0, 0.0, -1.0, 0.5, 2.0, 0.0, 1.0, 3.0;
+
+    const auto s = createN< NamedParameter >( v, "s" );
+    const auto sd = create< NamedParameter >( v, true, "s" );
+
+    const VectorNT< 3, 3 > r = m.cast< ScalarN< 3 > >() * s;
+    const Vector3 rd = m.cast< Scalar >() * sd;
+    const ScalarN< 3 > d = s.dot( r );
+    const Scalar dd = sd.dot( rd );
+
+    for ( int i = 0; i < 3; i++ )
+    {
+        REQUIRE( almostEqual( r[i].value(), rd[i].value() ) );
+        REQUIRE( r[i].partial().isApprox( m.row( i ) ) );
+    }
+    REQUIRE( almostEqual( d.value(), dd.value() ) );
+    REQUIRE( d.partial().isApprox( ( ( m + m.transpose() ) * v ).transpose() ) );
+}
@@ -0,0 +1,131 @@
+#include "TestSuite.h"
+
+
+using namespace metal;
+
+
+TEST_CASE( "Chains of binary operations are flattened", "[scalar_nary_flatten]" )
+{
+    const Scalar a{ 1.0, "a" };
+    const Scalar b{ 2.0, "b" };
+    const Scalar c{ 3.0, "c" };
+    const Scalar d{ 4.0 };
+
+    SECTION( "Node types" )
+    {
+        using Sum3 = ScalarNaryOp< NaryAdditionOp, Scalar, Scalar, Scalar >;
+        using Sum4 = ScalarNaryOp< NaryAdditionOp, Scalar, Scalar, Scalar, Scalar >;
+        using Product3 = ScalarNaryOp< NaryMultiplyOp, Scalar, Scalar, Scalar >;
+        using Binary = ScalarBinaryOp< Scalar, Scalar, BinaryAdditionOp >;
+        using Mixed = ScalarBinaryOp< ScalarBinaryOp< Scalar, Scalar, BinaryMultiplyOp >, Scalar,
+            BinaryAdditionOp >;
+
+        REQUIRE( std::is_same< decltype( a + b ), Binary >::value );
+        REQUIRE( std::is_same< decltype( a + b - c ), Sum3 >::value );
+        REQUIRE( std::is_same< decltype( a - b + c + d ), Sum4 >::value );
+        REQUIRE( std::is_same< decltype( a * b * c ), Product3 >::value );
+        REQUIRE( std::is_same< decltype( a * b + c ), Mixed >::value );
+    }
+
+    SECTION( "Weighted sum" )
+    {
+        const Scalar x = a - b + c * 2.0 - d + a;
+
+        REQUIRE_VALUE_EQUAL( x, 2.0 );
+        REQUIRE( x.size() == 3 );
+        REQUIRE( almostEqual( x.at( a )[0], 2.0 ) );
+        REQUIRE( almostEqual( x.at( b )[0], -1.0 ) );
+        REQUIRE( almostEqual( x.at( c )[0], 2.0 ) );
+    }
+
+    SECTION( "Product" )
+    {
+        const Scalar x = a * b * c * d * b;
+
+        REQUIRE_VALUE_EQUAL( x, 48.0 );
+        REQUIRE( x.size() == 3 );
+        REQUIRE( almostEqual( x.at( a )[0], 48.0 ) );
+        REQUIRE( almostEqual( x.at( b )[0], 48.0 ) );
+        REQUIRE( almostEqual( x.at( c )[0], 16.0 ) );
+    }
+
+    SECTION( "Product with a zero operand" )
+    {
+        const Scalar zero{ 0.0, "zero" };
+        const Scalar x = a * zero * c;
+
+        REQUIRE_VALUE_EQUAL( x, 0.0 );
+        REQUIRE( almostEqual( x.at( a )[0], 0.0 ) );
+        REQUIRE( almostEqual( x.at( zero )[0], 3.0 ) );
+        REQUIRE( almostEqual( x.at( c )[0], 0.0 ) );
+    }
+
+    SECTION( "Nodes built from all operands at once" )
+    {
+        const Scalar zero{ 0.0, "zero" };
+        const auto s = sum( a, b * 2.0, c, d, a );
+        const Scalar p = product( a, zero, c, d, b );
+        const Scalar chained = a + b * 2.0 + c + d + a;
+        using Sum5 = ScalarNaryOp< NaryAdditionOp, Scalar,
+            ScalarUnaryOp< Scalar, UnaryMultiplyOp >, Scalar, Scalar, Scalar >;
+
+        REQUIRE( std::is_same< decltype( s ), const Sum5 >::value );
+        REQUIRE_VALUE_EQUAL( s, 13.0 );
+        REQUIRE( Scalar{ s }.partial().toDense() == chained.partial().toDense() );
+        REQUIRE_VALUE_EQUAL( p, 0.0 );
+        REQUIRE( almostEqual( p.at( zero )[0], 24.0 ) );
+        REQUIRE( almostEqual( p.at( a )[0], 0.0 ) );
+        REQUIRE( almostEqual( Scalar{ product( a, b, c, b ) }.at( b )[0], 12.0 ) );
+    }
+
+    SECTION( "Accumulation gives the same partials as scattering" )
+    {
+        const Scalar x{ sin( a ) * b * cos( c ) * b, Evaluation::Accumulate };
+        const Scalar y{ sin( a ) * b * cos( c ) * b, Evaluation::Scatter };
+
+        REQUIRE( x.partial().toDense() == y.partial().toDense() );
+        REQUIRE( almostEqual( x.at( b )[0], 4.0 * std::sin( 1.0 ) * std::cos( 3.0 ) ) );
+    }
+}
+
+
+TEST_CASE( "Flat operations merge the parameters of all operands", "[scalar_nary_parameters]" )
+{
+    const Scalar a{ 1.0, "a" };
+    const Scalar b{ 2.0, "b" };
+    const Scalar c{ 3.0, "c" };
+    const Scalar d{ 4.0 };
+    const Scalar ab = a + 2.0 * b;
+
+    SECTION( "Union in canonical order" )
+    {
+        const ParameterPtrVector expected{ a.parameters().front(), b.parameters().front(),
+            c.parameters().front() };
+
+        REQUIRE( ( c + b + d + a ).parameters() == expected );
+        REQUIRE( ( ab + c + ab + d ).parameters() == expected );
+        REQUIRE( ( c + b + d + a ).dim() == 3 );
+        REQUIRE( ( c + b + d + a ).contains( b.parameters().front() ) );
+        REQUIRE( !( c + b + d + a ).contains( nullptr ) );
+    }
+
+    SECTION( "Operands with the same parameters share their layout" )
+    {
+        REQUIRE( ( d + ab + d ).parameters() == ab.parameters() );
+        REQUIRE( Scalar{ d + ab + d }.layout() == ab.layout() );
+        REQUIRE( Scalar{ ab * ab * ab }.layout() == ab.layout() );
+        REQUIRE( ( d + d + d ).parameters().empty() );
+        REQUIRE( ( d * d * d ).dim() == 0 );
+    }
+
+    SECTION( "Multi-dimensional parameters" )
+    {
+        const Scalar u{ 1.0, std::make_shared< NamedParameter >( 3, "u" ),
+            EigenRowVector::LinSpaced( 3, 1.0, 3.0 ) };
+        const Scalar x = u + a - u * 2.0 + u;
+
+        REQUIRE( x.dim() == 4 );
+        REQUIRE( ( x.at( u ) - EigenRowVector::Zero( 3 ) ).norm() == 0.0 );
+        REQUIRE( almostEqual( x.at( a )[0], 1.0 ) );
+    }
+}
@@ -4,6 +4,11 @@
 using namespace metal;
 
 
+// Containers of scalars move the partials instead of copying them when reallocating
+static_assert( std::is_nothrow_move_constructible< Scalar >::value, "Scalar moves may throw" );
+static_assert( std::is_nothrow_move_assignable< Scalar >::value, "Scalar moves may throw" );
+
+
 TEST_CASE( "Scalars can be created", "[scalar_construct]" )
 {
     SECTION( "Simple construction from value" )
@@ -111,3 +116,297 @@ TEST_CASE( "Scalars can be modified by dividing by numbers", "[scalar_modify_div
         REQUIRE_PARTIALS_EQUAL( x, 1.0 / 1.5 );
     }
 }
+
+
+TEST_CASE( "Scalars can be evaluated from expressions", "[scalar_evaluate]" )
+{
+    const Scalar a{ 1.5, "a" };
+    const Scalar b{ -0.5, "b" };
+    const Scalar c{ 2.0, "c" };
+    const Scalar d{ 3.0 };
+    const Scalar ab = a * b + 2.0 * a;
+
+    SECTION( "Scatter and accumulate evaluations agree" )
+    {
+        const Scalar x{ sin( ab ) * c - ( a + d ) / b, Evaluation::Scatter };
+        const Scalar y{ sin( ab ) * c - ( a + d ) / b, Evaluation::Accumulate };
+
+        REQUIRE_VALUE_EQUAL( x, y.value() );
+        REQUIRE( x.layout() == y.layout() );
+        REQUIRE( x.partial().toDense().isApprox( y.partial().toDense() ) );
+    }
+
+    SECTION( "Value-only evaluation" )
+    {
+        const double value = valueOf( sin( ab ) * c - ( a + d ) / b );
+
+        REQUIRE( value == Scalar{ sin( ab ) * c - ( a + d ) / b }.value() );
+        REQUIRE( valueOf( 2.5 ) == 2.5 );
+    }
+
+    SECTION( "Scatter evaluation gives the analytic partials" )
+    {
+        const Scalar x = sin( ab ) * c - ( a + d ) / b;
+        const double dab = std::cos( ab.value() ) * c.value();
+
+        REQUIRE_VALUE_EQUAL( x, std::sin( ab.value() ) * c.value() - 4.5 / b.value() );
+        REQUIRE( almostEqual( x.at( a ).value(), dab * ( b.value() + 2.0 ) - 1.0 / b.value(), 1e-14 ) );
+        REQUIRE( almostEqual( x.at( b ).value(), dab * a.value() + 4.5 / 0.25, 1e-14 ) );
+        REQUIRE( almostEqual( x.at( c ).value(), std::sin( ab.value() ), 1e-14 ) );
+    }
+
+    SECTION( "Leaves sharing a layout are summed as whole vectors" )
+    {
+        const Scalar u = ab + c;
+        const Scalar v = ab * c - 1.0;
+        const Scalar x{ sin( u ) * v - d * u / v, Evaluation::Scatter };
+        const Scalar y{ sin( u ) * v - d * u / v, Evaluation::Accumulate };
+
+        REQUIRE( x.layout() == u.layout() );
+        REQUIRE_VALUE_EQUAL( x, y.value() );
+        REQUIRE( x.partial().toDense().isApprox( y.partial().toDense() ) );
+        REQUIRE( Scalar{ d * d + 1.0 }.layout() == nullptr );
+        REQUIRE( Scalar{ d * d + 1.0 }.dim() == 0 );
+    }
+}
+
+
+TEST_CASE( "Scalars store sparse partials", "[scalar_sparse]" )
+{
+    const int dim = 4 * PartialVector::SparseMinSize;
+    const auto p = std::make_shared< NamedParameter >( dim, "bias" );
+
+    std::vector< Scalar > bias;
+    for ( int i = 0; i < dim; i++ )
+    {
+        bias.emplace_back( 0.1 * i, p, EigenRowVector::Unit( dim, i ) );
+    }
+    const Scalar a{ 2.0, "a" };
+
+    SECTION( "Unit partials are compressed" )
+    {
+        REQUIRE( bias[5].partial().isSparse() );
+        REQUIRE( bias[5].partial().nonZeros() == 1 );
+        REQUIRE( bias[5].at( p ) == EigenRowVector::Unit( dim, 5 ) );
+    }
+
+    SECTION( "Low fill expressions are merged sparsely" )
+    {
+        const Scalar x = bias[1] * bias[2] + sin( bias[3] ) * a - bias[1];
+        const Scalar y{ bias[1] * bias[2] + sin( bias[3] ) * a - bias[1], Evaluation::Accumulate };
+
+        REQUIRE( x.partial().isSparse() );
+        REQUIRE( x.partial().nonZeros() == 4 );
+        REQUIRE( x.layout() == y.layout() );
+        REQUIRE( x.partial().toDense().isApprox( y.partial().toDense() ) );
+        REQUIRE( almostEqual( x.at( p )[1], bias[2].value() - 1.0, 1e-14 ) );
+        REQUIRE( almostEqual( x.at( a ).value(), std::sin( bias[3].value() ), 1e-14 ) );
+    }
+
+    SECTION( "High fill expressions are dense" )
+    {
+        Scalar sum = 0.0 * bias[0];
+        for ( const auto& b : bias )
+        {
+            sum.multAndAdd( b, 2.0 );
+        }
+        const Scalar x = sum * a;
+
+        REQUIRE( !x.partial().isSparse() );
+        REQUIRE( x.at( p ) == EigenRowVector::Constant( dim, 2.0 * a.value() ) );
+    }
+
+    SECTION( "Arithmetic keeps sparse partials" )
+    {
+        Scalar x = bias[4] + bias[6];
+        x *= 2.0;
+        x += Scalar{ bias[4] - bias[7] };
+        x.multAndAdd( bias[4] + bias[6], 1.0 );
+
+        REQUIRE( x.partial().isSparse() );
+        REQUIRE( x.at( p )[4] == 4.0 );
+        REQUIRE( x.at( p )[6] == 3.0 );
+        REQUIRE( x.at( p )[7] == -1.0 );
+    }
+}
+
+
+TEST_CASE( "Scalars share parameter layouts", "[scalar_layout]" )
+{
+    const Scalar a{ 1.5, "a" };
+    const Scalar b{ -0.5, "b" };
+
+    SECTION( "Parameters have dense creation ordered identifiers" )
+    {
+        const auto pa = a.parameters().front();
+        const auto pb = b.parameters().front();
+        const auto pc = std::make_shared< NamedParameter >( 2, "c" );
+        const NamedParameter copy{ *pc };
+
+        REQUIRE( pb->id() == pa->id() + 1 );
+        REQUIRE( pc->id() == pb->id() + 1 );
+        REQUIRE( copy.id() == pc->id() + 1 );
+        REQUIRE( ParameterRegistry::instance().count() == copy.id() + 1 );
+    }
+
+    SECTION( "Scalars without partials have no layout" )
+    {
+        REQUIRE( Scalar{ 1.0 }.layout() == nullptr );
+        REQUIRE( Scalar{ 2.0 * Scalar{ 1.0 } }.layout() == nullptr );
+    }
+
+    SECTION( "Same parameters give the same layout object" )
+    {
+        const Scalar x = a * b;
+        const Scalar y = b - sin( a );
+        const Scalar z = 2.0 * a;
+
+        REQUIRE( x.layout() != nullptr );
+        REQUIRE( x.layout() == y.layout() );
+        REQUIRE( z.layout() == a.layout() );
+        REQUIRE( x.layout() != a.layout() );
+        REQUIRE( x.layout()->dim() == 2 );
+        REQUIRE( x.layout()->size() == 2 );
+    }
+
+    SECTION( "Layouts are ordered canonically" )
+    {
+        const auto pa = a.parameters().front();
+        const auto pb = b.parameters().front();
+        const auto layout = ParameterLayout::create( { pb, pa } );
+        REQUIRE( layout == Scalar{ b * a }.layout() );
+        REQUIRE( layout == ParameterLayout::create( { pa, pb, pa } ) );
+        REQUIRE( layout->parameters().front() == pa );
+        REQUIRE( layout->ids() == std::vector< ParameterId >{ pa->id(), pb->id() } );
+        REQUIRE( layout->offset( layout->parameters()[1] ) == 1 );
+        REQUIRE( layout->offset( ParameterPtr{} ) < 0 );
+    }
+
+    SECTION( "Layouts are merged by their identifiers" )
+    {
+        const Scalar c{ 2.0, "c" };
+        const LayoutPtr ab = Scalar{ a * b }.layout();
+        const LayoutPtr none{};
+
+        REQUIRE( ParameterLayout::merge( a.layout(), none ) == a.layout() );
+        REQUIRE( ParameterLayout::merge( ab, a.layout() ) == ab );
+        REQUIRE( ParameterLayout::merge( b.layout(), a.layout() ) == ab );
+        REQUIRE( ParameterLayout::merge( { &c.layout(), &none, &b.layout(), &a.layout() } )
+            == Scalar{ a + b + c }.layout() );
+        REQUIRE( ParameterLayout::merge( { &none } ) == nullptr );
+    }
+}
+
+
+TEST_CASE( "Scalars can be assigned expressions in place", "[scalar_assign]" )
+{
+    const Scalar a{ 1.5, "a" };
+    const Scalar b{ -0.5, "b" };
+    const Scalar c{ 2.0, "c" };
+
+    SECTION( "Compound operators with expressions" )
+    {
+        Scalar x = a * b;
+        x += sin( c );
+        x -= a * c;
+        x *= b + c;
+        x /= 2.0 * a;
+
+        const Scalar y = ( a * b + sin( c ) - a * c ) * ( b + c ) / ( 2.0 * a );
+        REQUIRE( almostEqual( x.value(), y.value() ) );
+        REQUIRE( x.layout() == y.layout() );
+        REQUIRE( x.at( a ).isApprox( y.at( a ) ) );
+        REQUIRE( x.at( b ).isApprox( y.at( b ) ) );
+        REQUIRE( x.at( c ).isApprox( y.at( c ) ) );
+    }
+
+    SECTION( "Expressions referring to the assigned scalar" )
+    {
+        Scalar x = b;
+        x = x * a + c;
+        x = 2.0 * x - x * x;
+
+        const Scalar y0 = b * a + c;
+        const Scalar y = 2.0 * y0 - y0 * y0;
+        REQUIRE( almostEqual( x.value(), y.value() ) );
+        REQUIRE( x.layout() == y.layout() );
+        REQUIRE( x.at( a ).isApprox( y.at( a ) ) );
+        REQUIRE( x.at( b ).isApprox( y.at( b ) ) );
+        REQUIRE( x.at( c ).isApprox( y.at( c ) ) );
+
+        x = x - x + 3.0;
+        REQUIRE( almostEqual( x.value(), 3.0 ) );
+        REQUIRE( x.at( a ).isZero() );
+        REQUIRE( x.at( c ).isZero() );
+    }
+
+    SECTION( "Addition of scalars with different layouts" )
+    {
+        Scalar x = a;
+        x += b;
+        x += Scalar{ 2.0 };
+        x.multAndAdd( c, 3.0 );
+
+        REQUIRE( almostEqual( x.value(), 9.0 ) );
+        REQUIRE( x.size() == 3 );
+        REQUIRE( x.at( a )[0] == 1.0 );
+        REQUIRE( x.at( b )[0] == 1.0 );
+        REQUIRE( x.at( c )[0] == 3.0 );
+    }
+
+    SECTION( "Expressions without partials" )
+    {
+        Scalar x = a;
+        x = 2.0 * Scalar{ 1.0 };
+
+        REQUIRE_VALUE_EQUAL( x, 2.0 );
+        REQUIRE_PARTIALS_EMPTY( x );
+    }
+
+    SECTION( "Compound operators with scalars without parameters" )
+    {
+        Scalar x = a * b + c;
+        const double* data = x.partial().data();
+        const EigenRowVector partial = x.partial().toDense();
+        x *= Scalar{ 4.0 };
+        x /= Scalar{ 2.0 };
+        x -= Scalar{ 1.0 };
+        x += Scalar{ 0.5 };
+
+        REQUIRE( x.partial().data() == data );
+        REQUIRE( almostEqual( x.value(), 2.0 * ( a.value() * b.value() + c.value() ) - 0.5 ) );
+        REQUIRE( x.partial().toDense() == 2.0 * partial );
+
+        Scalar y{ 3.0 };
+        y *= y;
+        REQUIRE_VALUE_EQUAL( y, 9.0 );
+        REQUIRE_PARTIALS_EMPTY( y );
+    }
+
+    SECTION( "Partial storage grows in place" )
+    {
+        std::vector< Scalar > params;
+        for ( int i = 0; i < 20; i++ )
+        {
+            params.emplace_back( 1.0 + i, "p" + std::to_string( i ) );
+        }
+
+        Scalar x = params[0];
+        for ( size_t i = 1; i < params.size(); i++ )
+        {
+            x = 0.5 * x + params[i];
+        }
+        const double* data = x.partial().data();
+        for ( int k = 0; k < 10; k++ )
+        {
+            for ( const auto& p : params )
+            {
+                x = 0.5 * x + p;
+            }
+        }
+
+        REQUIRE( x.partial().data() == data );
+        REQUIRE( x.size() == params.size() );
+        REQUIRE( almostEqual( x.at( params.back() )[0], 1.0 / ( 1.0 - std::pow( 0.5, 20 ) ), 1e-12 ) );
+    }
+}
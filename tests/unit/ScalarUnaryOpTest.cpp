@@ -49,6 +49,30 @@ inline double sqrt_( double x ) { return std::sqrt( x ); }
 inline metal::ScalarUnaryOp< metal::Scalar, metal::SquareRootOp >
 sqrt_( const metal::Scalar& x ) { return sqrt( x ); }
 
+inline double pow1( double x ) { return std::pow( x, 2.5 ); }
+inline metal::ScalarUnaryOp< metal::Scalar, metal::UnaryPowerOp< metal::PowerMode::Normal > >
+pow1( const metal::Scalar& x ) { return pow( x, 2.5 ); }
+
+inline double pow2( double x ) { return std::pow( 2.5, x ); }
+inline metal::ScalarUnaryOp< metal::Scalar, metal::UnaryPowerOp< metal::PowerMode::Reverse > >
+pow2( const metal::Scalar& x ) { return pow( 2.5, x ); }
+
+inline double pow3( double x ) { return std::pow( x, 3.0 ); }
+inline metal::ScalarUnaryOp< metal::Scalar, metal::UnaryPowerOp< metal::PowerMode::Normal > >
+pow3( const metal::Scalar& x ) { return pow( x, 3.0 ); }
+
+inline double ipow1( double x ) { return ( x * x * x ) * ( x * x * x ) * x; }
+inline metal::ScalarUnaryOp< metal::Scalar, metal::IntegerPowerOp< 7 > >
+ipow1( const metal::Scalar& x ) { return metal::pow< 7 >( x ); }
+
+inline double ipow2( double x ) { return ( 1.0 / x ) * ( 1.0 / x ) * ( 1.0 / x ); }
+inline metal::ScalarUnaryOp< metal::Scalar, metal::IntegerPowerOp< -3 > >
+ipow2( const metal::Scalar& x ) { return metal::pow< -3 >( x ); }
+
+inline double ipow3( double ) { return 1.0; }
+inline metal::ScalarUnaryOp< metal::Scalar, metal::IntegerPowerOp< 0 > >
+ipow3( const metal::Scalar& x ) { return metal::pow< 0 >( x ); }
+
 
 TEST_SCALAR_UNARY( "Unary negate operation", "[scalar_unary_negate]", negate, -10.0, 10.0, 100 )
 
@@ -84,3 +108,60 @@ TEST_SCALAR_UNARY( "Inverse tangent test", "[scalar_unary_atan]", atan, -100.0,
 TEST_SCALAR_UNARY( "Inverse sine hyperbolic test", "[scalar_unary_asinh]", asinh, -100.0, 100.0, 100 )
 TEST_SCALAR_UNARY( "Inverse cosine hyperbolic test", "[scalar_unary_acosh]", acosh, 1.0, 100.0, 100 )
 TEST_SCALAR_UNARY( "Inverse tangent hyperbolic test", "[scalar_unary_atanh]", atanh, -1.0, 1.0, 100 )
+
+TEST_SCALAR_UNARY( "Cube root test", "[scalar_unary_cbrt]", cbrt, 0.1, 10.0, 100 )
+
+TEST_SCALAR_UNARY( "Exponential test", "[scalar_unary_exp]", exp, -10.0, 10.0, 100 )
+TEST_SCALAR_UNARY( "Exponential minus one test", "[scalar_unary_expm1]", expm1, -10.0, 10.0, 100 )
+TEST_SCALAR_UNARY( "Logarithm test", "[scalar_unary_log]", log, 0.1, 10.0, 100 )
+TEST_SCALAR_UNARY( "Logarithm one plus test", "[scalar_unary_log1p]", log1p, -0.9, 10.0, 100 )
+TEST_SCALAR_UNARY( "Error function test", "[scalar_unary_erf]", erf, -3.0, 3.0, 100 )
+
+TEST_SCALAR_UNARY( "Power test 1", "[scalar_unary_pow_1]", pow1, 0.1, 10.0, 100 )
+TEST_SCALAR_UNARY( "Power test 2", "[scalar_unary_pow_2]", pow2, -10.0, 10.0, 100 )
+TEST_SCALAR_UNARY( "Power test 3", "[scalar_unary_pow_3]", pow3, -10.0, 10.0, 100 )
+
+TEST_SCALAR_UNARY( "Integer power test 1", "[scalar_unary_ipow_1]", ipow1, -3.0, 3.0, 100 )
+TEST_SCALAR_UNARY( "Integer power test 2", "[scalar_unary_ipow_2]", ipow2, 0.5, 10.0, 100 )
+TEST_SCALAR_UNARY( "Integer power test 3", "[scalar_unary_ipow_3]", ipow2, -10.0, -0.5, 100 )
+TEST_SCALAR_UNARY( "Integer power test 4", "[scalar_unary_ipow_4]", ipow3, -10.0, 10.0, 100 )
+
+
+TEST_CASE( "Power of a zero base", "[scalar_unary_pow_zero]" )
+{
+    const metal::Scalar x{ 0.0, "x" };
+
+    REQUIRE( almostEqual( metal::Scalar{ pow( x, 3.0 ) }.at( x )[0], 0.0 ) );
+    REQUIRE( almostEqual( metal::Scalar{ pow( x, 1.0 ) }.at( x )[0], 1.0 ) );
+    REQUIRE( almostEqual( metal::Scalar{ pow( x, x + 2.0 ) }.at( x )[0], 0.0 ) );
+    REQUIRE( almostEqual( metal::Scalar{ metal::pow< 3 >( x ) }.at( x )[0], 0.0 ) );
+    REQUIRE( almostEqual( metal::Scalar{ metal::pow< 1 >( x ) }.at( x )[0], 1.0 ) );
+}
+
+
+struct LegacyExpOp
+{
+    double applyToValue( double value ) const { return std::exp( value ); }
+    double partial( double value ) const { return std::exp( value ); }
+};
+
+struct FusedExpOp
+{
+    metal::UnaryResult apply( double value ) const
+    {
+        const double tmp = std::exp( value );
+        return metal::UnaryResult{ tmp, tmp };
+    }
+};
+
+TEST_CASE( "Unary operations with separate or fused partials", "[scalar_unary_protocol]" )
+{
+    const metal::Scalar x{ 0.5, "x" };
+    const metal::ScalarUnaryOp< metal::Scalar, LegacyExpOp > legacy{ x, LegacyExpOp{} };
+    const metal::ScalarUnaryOp< metal::Scalar, FusedExpOp > fused{ x, FusedExpOp{} };
+
+    REQUIRE( almostEqual( legacy.value(), std::exp( 0.5 ) ) );
+    REQUIRE( almostEqual( fused.value(), std::exp( 0.5 ) ) );
+    REQUIRE( almostEqual( metal::Scalar{ legacy }.at( x )[0], std::exp( 0.5 ) ) );
+    REQUIRE( almostEqual( metal::Scalar{ fused }.at( x )[0], std::exp( 0.5 ) ) );
+}
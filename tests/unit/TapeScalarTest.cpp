@@ -0,0 +1,104 @@
+#include "TestSuite.h"
+
+
+using namespace metal;
+
+
+TEST_CASE( "Tape scalars record to the thread-local tape", "[tape_scalar_record]" )
+{
+    Tape& tape = Tape::local();
+    tape.clear();
+
+    SECTION( "Constants are not recorded" )
+    {
+        const TapeScalar c{ 2.0 };
+        const TapeScalar d = sin( c ) * c + 1.0;
+
+        REQUIRE( c.index() < 0 );
+        REQUIRE( d.index() < 0 );
+        REQUIRE( tape.size() == 0 );
+        REQUIRE( d.gradient().size() == 0 );
+        REQUIRE( almostEqual( d.value(), std::sin( 2.0 ) * 2.0 + 1.0 ) );
+    }
+
+    SECTION( "One node per evaluated expression" )
+    {
+        const TapeScalar x{ 1.5, "x" };
+        const TapeScalar y{ -0.5, "y" };
+        const TapeScalar z = x * y - sin( x ) / 2.0;
+
+        REQUIRE( tape.size() == 3 );
+        REQUIRE( tape.independents() == 2 );
+        REQUIRE( z.index() == 2 );
+    }
+
+    SECTION( "Clearing the tape" )
+    {
+        const TapeScalar x{ 1.5, "x" };
+        const TapeScalar y = 2.0 * x;
+        REQUIRE( y.index() == 1 );
+        tape.clear();
+
+        REQUIRE( tape.size() == 0 );
+        REQUIRE( tape.independents() == 0 );
+        REQUIRE( TapeScalar{ 1.0, "x" }.index() == 0 );
+    }
+}
+
+
+TEST_CASE( "Tape scalars compute gradients in reverse mode", "[tape_scalar_gradient]" )
+{
+    Tape::local().clear();
+
+    const double a0 = 0.7;
+    const double b0 = -1.3;
+    const double c0 = 2.1;
+
+    SECTION( "Same partials as the forward mode" )
+    {
+        const Scalar a{ a0, "a" };
+        const Scalar b{ b0, "b" };
+        const Scalar c{ c0, "c" };
+        const Scalar ab = a * b + sqr( c );
+        const Scalar f = atan2( ab, c ) * cos( a ) - ab / ( b * c ) + 3.0 * a;
+
+        const TapeScalar ta{ a0, "a" };
+        const TapeScalar tb{ b0, "b" };
+        const TapeScalar tc{ c0, "c" };
+        const TapeScalar tab = ta * tb + sqr( tc );
+        const TapeScalar tf = atan2( tab, tc ) * cos( ta ) - tab / ( tb * tc ) + 3.0 * ta;
+
+        const Eigen::VectorXd gradient = tf.gradient();
+        REQUIRE( almostEqual( tf.value(), f.value(), 1e-15 ) );
+        REQUIRE( gradient.size() == 3 );
+        REQUIRE( almostEqual( gradient[0], f.at( a ).value(), 1e-14 ) );
+        REQUIRE( almostEqual( gradient[1], f.at( b ).value(), 1e-14 ) );
+        REQUIRE( almostEqual( gradient[2], f.at( c ).value(), 1e-14 ) );
+        REQUIRE( tf.gradient( "b" ) == gradient[1] );
+        REQUIRE_THROWS( tf.gradient( "d" ) );
+    }
+
+    SECTION( "Repeated leaves and in-place operations" )
+    {
+        const TapeScalar x{ a0, "x" };
+        TapeScalar y = x * x + x;
+        y *= 3.0;
+        y += 1.0;
+        y /= 2.0;
+
+        REQUIRE( almostEqual( y.value(), ( 3.0 * ( a0 * a0 + a0 ) + 1.0 ) / 2.0, 1e-15 ) );
+        REQUIRE( almostEqual( y.gradient()[0], 1.5 * ( 2.0 * a0 + 1.0 ), 1e-15 ) );
+    }
+
+    SECTION( "Gradient of intermediate nodes" )
+    {
+        const TapeScalar x{ a0, "x" };
+        const TapeScalar u = sin( x );
+        const TapeScalar y{ b0, "y" };
+        const TapeScalar v = u * y;
+
+        REQUIRE( almostEqual( u.gradient()[0], std::cos( a0 ), 1e-15 ) );
+        REQUIRE( u.gradient()[1] == 0.0 );
+        REQUIRE( almostEqual( v.gradient()[1], std::sin( a0 ), 1e-15 ) );
+    }
+}
@@ -133,12 +133,16 @@ template< typename Func, typename SFunc >
 inline void testBinary( Func func, SFunc sfunc, double x, double y, double eps = 1e-6,
     double rtol = 1e-6, double atol = 1e-9 )
 {
+    // The constant operands have to outlive the expressions referring to them
+    const metal::Scalar sx{ x };
+    const metal::Scalar sy{ y };
+
     const auto func1 = [&]( double x_ ) { return func( x_, y ); };
-    const auto sfunc1 = [&]( const metal::Scalar& x_ ) { return sfunc( x_, metal::Scalar{ y } ); };
+    const auto sfunc1 = [&]( const metal::Scalar& x_ ) { return sfunc( x_, sy ); };
     testUnary( func1, sfunc1, x, eps, rtol, atol );
 
     const auto func2 = [&]( double y_ ) { return func( x, y_ ); };
-    const auto sfunc2 = [&]( const metal::Scalar& y_ ) { return sfunc( metal::Scalar{ x }, y_ ); };
+    const auto sfunc2 = [&]( const metal::Scalar& y_ ) { return sfunc( sx, y_ ); };
     testUnary( func2, sfunc2, x, eps, rtol, atol );
 }
 
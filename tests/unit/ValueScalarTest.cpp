@@ -0,0 +1,104 @@
+#include "TestSuite.h"
+#include "src/Matrix.h"
+
+
+using namespace metal;
+
+
+template< typename Policy >
+BasicScalar< Policy > model( double a0, double b0 )
+{
+    using T = BasicScalar< Policy >;
+
+    const T a{ a0, "a" };
+    const T b{ b0, "b" };
+    const T ab = a * b;
+    return T{ sin( ab ) - 2.0 * a / b + sqrt( sqr( b ) ) * atan2( a, b ) + cosh( a ) - 1.0 };
+}
+
+template< typename Policy >
+BasicScalar< Policy > density( double h0, double k0 )
+{
+    using T = BasicScalar< Policy >;
+
+    const T h{ h0, "h" };
+    const T k{ k0, "k" };
+    const T rho = 1.225 * exp( -h / 8.5 ) + log1p( sqr( k ) ) - expm1( -k );
+    return T{ rho * pow( hypot( h, k ), 0.5 ) + pow( k, h / 10.0 ) + pow( 2.0, k ) + cbrt( h )
+        - log( h ) * erf( k ) + pow< 5 >( k ) * pow< -3 >( h ) };
+}
+
+
+TEST_CASE( "Value scalars can be created", "[value_scalar_construct]" )
+{
+    SECTION( "Parameter creating constructors are no-ops" )
+    {
+        const ValueScalar x{ 1.5 };
+        const ValueScalar y{ 2.5, "y" };
+        const ValueScalar z{ 3.5, std::make_shared< NamedParameter >( 2, "z" ),
+            EigenRowVector::Ones( 2 ) };
+
+        REQUIRE( almostEqual( x.value(), 1.5 ) );
+        REQUIRE( almostEqual( y.value(), 2.5 ) );
+        REQUIRE( almostEqual( z.value(), 3.5 ) );
+        REQUIRE( y.dim() == 0 );
+        REQUIRE( y.size() == 0 );
+        REQUIRE( z.parameters().empty() );
+        REQUIRE( !z.contains( nullptr ) );
+        REQUIRE_THROWS( z.at( nullptr ) );
+    }
+
+    SECTION( "In-place arithmetic" )
+    {
+        ValueScalar x{ 1.0, "x" };
+        x += 2.0;
+        x *= ValueScalar{ 4.0 };
+        x -= ValueScalar{ 2.0 };
+        x /= 2.0;
+        x.multAndAdd( ValueScalar{ 3.0 }, 2.0 );
+
+        REQUIRE( almostEqual( x.value(), 11.0 ) );
+    }
+}
+
+
+TEST_CASE( "Derivative policies select the scalar type", "[value_scalar_policy]" )
+{
+    REQUIRE( std::is_same< BasicScalar< WithDerivatives >, Scalar >::value );
+    REQUIRE( std::is_same< BasicScalar< NoDerivatives >, ValueScalar >::value );
+
+    SECTION( "Same model code with and without derivatives" )
+    {
+        for ( const auto& ab : PairVector{ { 0.5, 1.5 }, { -1.0, 2.0 }, { 2.0, -0.5 } } )
+        {
+            const Scalar x = model< WithDerivatives >( ab.first, ab.second );
+            const ValueScalar y = model< NoDerivatives >( ab.first, ab.second );
+
+            REQUIRE( almostEqual( y.value(), x.value(), 1e-15 ) );
+            REQUIRE( x.size() == 2 );
+            REQUIRE( y.size() == 0 );
+        }
+    }
+
+    SECTION( "Same math functions with and without derivatives" )
+    {
+        for ( const auto& hk : PairVector{ { 0.5, 1.5 }, { 10.0, 0.2 }, { 40.0, 3.0 } } )
+        {
+            const Scalar x = density< WithDerivatives >( hk.first, hk.second );
+            const ValueScalar y = density< NoDerivatives >( hk.first, hk.second );
+
+            REQUIRE( almostEqual( y.value(), x.value(), 1e-15 ) );
+            REQUIRE( x.size() == 2 );
+        }
+    }
+
+    SECTION( "Eigen matrices of value scalars" )
+    {
+        const Eigen::Matrix< ValueScalar, 3, 1 > v{ ValueScalar{ 1.0 }, ValueScalar{ 2.0 },
+            ValueScalar{ 3.0 } };
+        const Eigen::Matrix< ValueScalar, 3, 3 > m
+            = Eigen::Matrix3d::Identity().cast< ValueScalar >() * 2.0;
+
+        REQUIRE( almostEqual( v.dot( m * v ).value(), 28.0 ) );
+    }
+}